@@ -0,0 +1,290 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Multi-word anagrams of a phrase.
+
+   The operand is the phrase (anything but letters is ignored), optionally
+   followed by the minimum length of the words to use (default 3) and the
+   maximum number of words in an anagram (default no limit).
+
+   A phrase is a multiset of letters, kept as a vector of 26 counts. Only
+   words whose letter counts fit in the phrase are candidates. Each step
+   keeps only the candidates that fit in the letters that remain and picks
+   the remaining letter that the fewest of them have: some word must cover
+   it. Trying those words in order, a word excludes the earlier ones with
+   that letter from the rest of the anagram, so every set of words is found
+   once and not also in all its permutations. A remaining multiset that
+   turned out to have no anagram at all is remembered in a hash table, so
+   dead ends are not explored twice. A step also fails right away when a
+   letter is left that no candidate covers, or when the letters are too
+   many for the number of words still allowed.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define MAX_PHRASE 64			/* at most so many letters */
+
+struct cand {
+  const char *word;
+  unsigned len;
+  unsigned mask;			/* letters it has */
+  unsigned char count[26];		/* letter counts */
+};
+static struct cand *cands;
+static unsigned num_cands;
+static unsigned min_len = 3;
+static unsigned max_words = MAX_PHRASE;
+static unsigned long num_found;
+
+/* Memo of dead ends: remaining letters (and words allowed) for which no
+   anagram exists.
+*/
+struct memo {
+  unsigned char count[26];
+  unsigned char words;			/* words still allowed */
+  unsigned char used;
+};
+static struct memo *memo;
+static unsigned memo_size, memo_num;	/* size is a power of 2 */
+
+static unsigned memo_hash(const unsigned char count[26], unsigned words)
+{
+  unsigned h = 2166136261u, c;
+  for (c = 0; c < 26; c++)
+    h = (h ^ count[c]) * 16777619u;
+  return (h ^ words) * 16777619u;
+}
+
+/* The memo entry for count and words, or a fresh one to fill in. */
+static struct memo *memo_find(const unsigned char count[26], unsigned words)
+{
+  unsigned i = memo_hash(count, words) & (memo_size-1);
+  while (memo[i].used) {
+    if (memo[i].words == words && !memcmp(memo[i].count, count, 26))
+      return &memo[i];
+    i = (i+1) & (memo_size-1);
+  }
+  return &memo[i];
+}
+
+/* Record that no anagram exists for count and words. */
+static void memo_fail(const unsigned char count[26], unsigned words)
+{
+  if (2 * (memo_num+1) > memo_size) {
+    /* Grow to keep the table at most half full: */
+    struct memo *old = memo;
+    unsigned i, old_size = memo_size;
+    struct memo *grown = calloc(2 * old_size, sizeof(*grown));
+    if (!grown)
+      return;
+    memo = grown;
+    memo_size *= 2;
+    for (i = 0; i < old_size; i++)
+      if (old[i].used)
+	*memo_find(old[i].count, old[i].words) = old[i];
+    free(old);
+  }
+  struct memo *m = memo_find(count, words);
+  if (!m->used) {
+    memcpy(m->count, count, 26);
+    m->words = words;
+    m->used = 1;
+    memo_num++;
+  }
+}
+
+static int fits(const unsigned char *need, const unsigned char *have)
+{
+  unsigned c;
+  for (c = 0; c < 26; c++)
+    if (need[c] > have[c])
+      return 0;
+  return 1;
+}
+
+static unsigned chosen[MAX_PHRASE];	/* indices of the words so far */
+
+static int uint_cmp(const void *a, const void *b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  return x < y ? -1 : x > y;
+}
+
+/* Find the anagrams of the rest letters (rest_len of them, with mask
+   rest_mask) using at most words words among the n candidates in list.
+   If complete, list has all candidates that fit. Returns whether any.
+*/
+static int solve(unsigned char rest[26], unsigned rest_len, unsigned rest_mask,
+		 unsigned words, const unsigned *list, unsigned n,
+		 int complete, unsigned depth)
+{
+  unsigned i, j;
+
+  if (!rest_len) {
+    unsigned sorted[MAX_PHRASE];
+    memcpy(sorted, chosen, depth * sizeof(*sorted));
+    qsort(sorted, depth, sizeof(*sorted), uint_cmp);
+    for (i = 0; i < depth; i++) {
+      if (i)
+	fputc(' ', stdout);
+      fputs(cands[sorted[i]].word, stdout);
+    }
+    fputc('\n', stdout);
+    num_found++;
+    return 1;
+  }
+  if (!words || !n || (max_results && num_found >= max_results))
+    return 0;
+  if (memo_find(rest, words)->used)
+    return 0;
+
+  /* Keep the candidates that fit; count per letter how many have it: */
+  unsigned *next = malloc(2 * n * sizeof(*next)), k = 0, covered = 0;
+  unsigned having[26] = { 0 };
+  if (!next)
+    return 0;
+  for (i = 0; i < n; i++) {
+    struct cand *c = &cands[list[i]];
+    if (c->len <= rest_len && !(c->mask & ~rest_mask)
+	&& fits(c->count, rest)) {
+      unsigned m = c->mask;
+      next[k++] = list[i];
+      covered |= m;
+      for (; m; m &= m-1)
+	having[__builtin_ctz(m)]++;
+    }
+  }
+
+  int any = 0;
+  /* Longest first, so next[0] is the longest word that fits: */
+  if (rest_mask & ~covered || (k && cands[next[0]].len * words < rest_len))
+    k = 0;
+
+  /* Some word must cover the letter fewest words have: */
+  unsigned l, rare = 0, fewest = ~0u;
+  for (l = 0; l < 26; l++)
+    if ((rest_mask >> l) & 1 && having[l] < fewest) {
+      fewest = having[l];
+      rare = l;
+    }
+  for (i = 0; i < k; i++) {
+    struct cand *c = &cands[next[i]];
+    if (!((c->mask >> rare) & 1))
+      continue;
+    /* This is the first word with the rare letter; earlier ones with it
+       are out, so each set of words is found in one way only:
+    */
+    unsigned *sub = next + k, m = 0, mask = rest_mask;
+    for (j = 0; j < k; j++)
+      if (j >= i || !((cands[next[j]].mask >> rare) & 1))
+	sub[m++] = next[j];
+    for (l = 0; l < 26; l++)
+      if (c->count[l] && !(rest[l] -= c->count[l]))
+	mask &= ~(1u << l);
+    /* The smaller list is still complete if none of those left out fit: */
+    int sub_complete = complete;
+    for (j = 0; sub_complete && j < i; j++)
+      if ((cands[next[j]].mask >> rare) & 1
+	  && cands[next[j]].len <= rest_len - c->len
+	  && fits(cands[next[j]].count, rest))
+	sub_complete = 0;
+    chosen[depth] = next[i];
+    any |= solve(rest, rest_len - c->len, mask, words-1, sub, m,
+		 sub_complete, depth+1);
+    for (l = 0; l < 26; l++)
+      rest[l] += c->count[l];
+  }
+  free(next);
+  /* Only a dead end with all candidates holds for any list: */
+  if (!any && complete)
+    memo_fail(rest, words);
+  return any;
+}
+
+/* Longest first, then alphabetical. */
+static int cand_cmp(const void *a, const void *b)
+{
+  const struct cand *x = a, *y = b;
+  if (x->len != y->len)
+    return x->len < y->len ? 1 : -1;
+  return strcmp(x->word, y->word);
+}
+
+int anagram_main(int argc, char *argv[])
+{
+  unsigned char phrase[26] = { 0 };
+  unsigned phrase_len = 0, phrase_mask = 0, len, i;
+  const char *p;
+
+  for (p = argv[1]; *p; p++)
+    if (isalpha(*p)) {
+      unsigned c = toupper(*p)-'A';
+      if (++phrase_len > MAX_PHRASE) {
+	fprintf(stderr, "(E) Phrase too long; at most %u letters\n",
+		MAX_PHRASE);
+	return 3;
+      }
+      phrase[c]++;
+      phrase_mask |= 1u << c;
+    }
+  if (argc > 2)
+    min_len = atoi(argv[2]);
+  if (min_len < MIN_WORD_LEN)
+    min_len = MIN_WORD_LEN;
+  if (argc > 3 && atoi(argv[3]) > 0)
+    max_words = atoi(argv[3]);
+
+  /* Candidate words: those that fit in the phrase. */
+  unsigned total = 0;
+  for (len = min_len; len <= MAX_WORD_LEN; len++)
+    total += vocab_count(len);
+  cands = malloc(total * sizeof(*cands));
+  unsigned *list = malloc(total * sizeof(*list));
+  memo_size = 1024;
+  memo = calloc(memo_size, sizeof(*memo));
+  if (!cands || !list || !memo) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (len = min_len; len <= MAX_WORD_LEN && len <= phrase_len; len++) {
+    const struct letter_masks *lm = vocab_masks(len);
+    const char **wl = vocab_words(len);
+    unsigned n = vocab_count(len);
+    if (!lm) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    for (i = 0; i < n; i++) {
+      if (lm[i].once & ~phrase_mask)
+	continue;
+      struct cand *c = &cands[num_cands];
+      memset(c->count, 0, 26);
+      for (p = wl[i]; *p; p++)
+	c->count[*p-'A']++;
+      if (!fits(c->count, phrase))
+	continue;
+      c->word = wl[i];
+      c->len = len;
+      c->mask = lm[i].once;
+      num_cands++;
+    }
+  }
+  qsort(cands, num_cands, sizeof(*cands), cand_cmp);
+  for (i = 0; i < num_cands; i++)
+    list[i] = i;
+
+  fprintf(stderr, "Anagrams of %u letters from %u candidate words\n",
+	  phrase_len, num_cands);
+  if (phrase_len)
+    solve(phrase, phrase_len, phrase_mask, max_words, list, num_cands, 1, 0);
+  fprintf(stderr, "%lu anagram%s\n", num_found, num_found == 1 ? "" : "s");
+  free(list);
+  free(cands);
+  free(memo);
+  return 0;
+}
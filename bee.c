@@ -0,0 +1,70 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Spelling Bee: words made of a set of letters, each of which may be used
+   any number of times, that contain the centre letter.
+
+   The operand is the set of letters (the centre letter given with -b may
+   be part of it or not), optionally followed by the minimum word length,
+   default 4. Each word is reduced to the 26-bit mask of its letters, so a
+   word qualifies if its mask is a subset of the letter set and has the
+   centre letter; a pangram uses every letter of the set and is marked *.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+int bee_main(int argc, char *argv[])
+{
+  unsigned set = 0, centre, min_len = 4, len;
+  const char *p;
+
+  if (!isalpha(bee_centre[0]) || bee_centre[1]) {
+    fprintf(stderr, "(E) Expect a single centre letter\n");
+    return 3;
+  }
+  centre = 1u << (toupper(bee_centre[0])-'A');
+  for (p = argv[1]; *p; p++) {
+    if (!isalpha(*p)) {
+      fprintf(stderr, "(E) Expect only letters: %s\n", argv[1]);
+      return 3;
+    }
+    set |= 1u << (toupper(*p)-'A');
+  }
+  set |= centre;
+  if (argc > 2 && isdigit(argv[2][0])) {
+    min_len = atoi(argv[2]);
+    if (min_len < MIN_WORD_LEN)
+      min_len = MIN_WORD_LEN;
+  }
+
+  unsigned total = 0, pangrams = 0;
+  for (len = min_len; len <= MAX_WORD_LEN; len++) {
+    const struct letter_masks *lm = vocab_masks(len);
+    const char **wl = vocab_words(len);
+    unsigned i, n = vocab_count(len);
+    if (!lm) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    for (i = 0; i < n; i++) {
+      unsigned m = lm[i].once;
+      if (m & ~set || !(m & centre))
+	continue;
+      total++;
+      fputs(wl[i], stdout);
+      if (m == set) {
+	pangrams++;
+	fputs(" *", stdout);
+      }
+      fputc('\n', stdout);
+    }
+  }
+  fprintf(stderr, "%u word%s, %u pangram%s\n", total, total == 1 ? "" : "s",
+	  pangrams, pangrams == 1 ? "" : "s");
+  return 0;
+}
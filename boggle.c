@@ -0,0 +1,328 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Boggle: the words traced through adjacent cells of a letter grid.
+
+   The operand is the board, its rows separated by /, e.g. SERS/PATG/LINE/
+   SERS, optionally followed by the minimum word length (default 3). A Q
+   stands for QU. A word may use each cell once and goes from a cell to
+   any of its (at most 8) neighbours. With operand - the boards are read
+   from stdin, one per line, and solved in parallel (-j); each gets one
+   line of output: the number of words, their score and the words.
+
+   The search is a depth-first walk over the board that follows the trie
+   of the vocabulary at the same time, so a path stops as soon as no word
+   starts with its letters. A word found along several paths is counted
+   once: each trie node remembers the last board it was found on.
+*/
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define MAX_CELLS 64			/* so that used cells fit in a mask */
+
+static const struct trie_node *trie;
+static unsigned num_nodes;
+static unsigned min_len = 3;
+
+struct board {
+  unsigned cells;
+  char letter[MAX_CELLS];		/* 0-25 */
+  unsigned num_adj[MAX_CELLS];
+  unsigned char adj[MAX_CELLS][8];
+};
+
+/* Per thread: the board being solved and what was found on it. */
+struct solver {
+  const struct board *b;
+  unsigned *stamp;			/* per trie node: board it was found */
+  unsigned id;				/* of the board being solved */
+  char word[MAX_CELLS*2+1];
+  char *out;				/* words found, separated by spaces */
+  size_t out_len, out_max;
+  unsigned count;
+  int score;
+};
+
+/* Points per word length as in Boggle; 8 letters and more score 11. */
+static int word_score(unsigned len)
+{
+  static const int points[] = { 0, 0, 0, 1, 1, 2, 3, 5 };
+  return len < 8 ? points[len] : 11;
+}
+
+/* Parse the board text into b; returns 0 if malformed. */
+static int parse_board(const char *text, struct board *b)
+{
+  unsigned r = 0, c = 0, width = 0, i, j;
+  const char *p;
+
+  b->cells = 0;
+  for (p = text; *p && *p != '\n'; p++) {
+    if (*p == '/') {
+      if (!c || (width && c != width))
+	return 0;
+      width = c;
+      c = 0;
+      r++;
+      continue;
+    }
+    if (!isalpha(*p) || b->cells == MAX_CELLS)
+      return 0;
+    b->letter[b->cells++] = toupper(*p)-'A';
+    c++;
+  }
+  if (!c || (width && c != width))
+    return 0;
+  if (!width)
+    width = c;
+  for (i = 0; i < b->cells; i++) {
+    int ri = i / width, ci = i % width, dr, dc;
+    b->num_adj[i] = 0;
+    for (dr = -1; dr <= 1; dr++)
+      for (dc = -1; dc <= 1; dc++) {
+	int rj = ri+dr, cj = ci+dc;
+	if ((dr || dc) && rj >= 0 && rj <= (int) r && cj >= 0
+	    && cj < (int) width) {
+	  j = rj * width + cj;
+	  b->adj[i][b->num_adj[i]++] = j;
+	}
+      }
+  }
+  return 1;
+}
+
+static int add_word(struct solver *s, unsigned len)
+{
+  if (s->out_len + len + 2 > s->out_max) {
+    size_t max = s->out_max ? 2 * s->out_max : 1024;
+    char *more = realloc(s->out, max);
+    if (!more)
+      return 0;
+    s->out = more;
+    s->out_max = max;
+  }
+  if (s->out_len)
+    s->out[s->out_len++] = ' ';
+  memcpy(s->out + s->out_len, s->word, len);
+  s->out_len += len;
+  s->out[s->out_len] = '\0';
+  return 1;
+}
+
+/* Continue the word of len letters at trie node n from cell. */
+static void walk(struct solver *s, unsigned cell, unsigned n, unsigned len,
+		 unsigned long long used)
+{
+  const struct board *b = s->b;
+  unsigned c = b->letter[cell], i;
+
+  if (!((trie[n].mask >> c) & 1))
+    return;
+  n = trie_child(trie, n, c);
+  s->word[len++] = 'A'+c;
+  if (c == 'Q'-'A') {
+    if (!((trie[n].mask >> ('U'-'A')) & 1))
+      return;
+    n = trie_child(trie, n, 'U'-'A');
+    s->word[len++] = 'U';
+  }
+  if (trie[n].end && len >= min_len && s->stamp[n] != s->id) {
+    s->stamp[n] = s->id;
+    if (add_word(s, len)) {
+      s->count++;
+      s->score += word_score(len);
+    }
+  }
+  if (!trie[n].mask)
+    return;
+  used |= 1ULL << cell;
+  for (i = 0; i < b->num_adj[cell]; i++) {
+    unsigned next = b->adj[cell][i];
+    if (!((used >> next) & 1))
+      walk(s, next, n, len, used);
+  }
+}
+
+static int str_cmp(const void *a, const void *b)
+{
+  return strcmp(*(const char **) a, *(const char **) b);
+}
+
+/* Put the words found in alphabetical order; returns 0 if out of memory. */
+static int sort_words(struct solver *s)
+{
+  char **wl, *copy, *w;
+  unsigned i = 0, j;
+  if (!s->count)
+    return 1;
+  wl = malloc(s->count * sizeof(*wl));
+  copy = strdup(s->out);
+  if (!wl || !copy) {
+    free(wl);
+    free(copy);
+    return 0;
+  }
+  /* Split on the spaces (strtok() is not thread safe): */
+  for (w = copy; w; w = strchr(w, ' ')) {
+    if (*w == ' ')
+      *w++ = '\0';
+    wl[i++] = w;
+  }
+  qsort(wl, i, sizeof(*wl), str_cmp);
+  s->out_len = 0;
+  for (j = 0; j < i; j++) {
+    size_t len = strlen(wl[j]);
+    if (j)
+      s->out[s->out_len++] = ' ';
+    memcpy(s->out + s->out_len, wl[j], len);
+    s->out_len += len;
+  }
+  s->out[s->out_len] = '\0';
+  free(wl);
+  free(copy);
+  return 1;
+}
+
+static void solve(struct solver *s, const struct board *b, unsigned id)
+{
+  unsigned cell;
+  s->b = b;
+  s->id = id;
+  s->out_len = 0;
+  s->count = 0;
+  s->score = 0;
+  if (s->out)
+    s->out[0] = '\0';
+  for (cell = 0; cell < b->cells; cell++)
+    walk(s, cell, 0, 0, 0);
+  sort_words(s);
+}
+
+static int solver_init(struct solver *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->stamp = calloc(num_nodes, sizeof(*s->stamp));
+  return s->stamp != NULL;
+}
+
+/* Boards read from stdin and the lines of output for them: */
+static char **lines;
+static char **results;
+static unsigned num_lines;
+static unsigned next_line;
+
+static void *boggle_worker(void *arg)
+{
+  struct solver s;
+  struct board b;
+  unsigned i;
+  (void) arg;
+  if (!solver_init(&s))
+    return NULL;
+  while ((i = __atomic_fetch_add(&next_line, 1, __ATOMIC_RELAXED))
+	 < num_lines) {
+    char head[32];
+    if (!parse_board(lines[i], &b)) {
+      results[i] = strdup("(E) Malformed board");
+      continue;
+    }
+    solve(&s, &b, i+1);
+    snprintf(head, sizeof(head), "%u %d", s.count, s.score);
+    results[i] = malloc(strlen(head) + s.out_len + 2);
+    if (results[i])
+      sprintf(results[i], s.out_len ? "%s %s" : "%s", head,
+	      s.out_len ? s.out : "");
+  }
+  free(s.out);
+  free(s.stamp);
+  return NULL;
+}
+
+/* Solve the boards on the lines of fp in parallel. */
+static int boggle_stream(FILE *fp)
+{
+  char buf[256];
+  unsigned max = 0, i, t, nt = num_threads ? num_threads : 1;
+
+  while (fgets(buf, sizeof(buf), fp)) {
+    buf[strcspn(buf, "\r\n")] = '\0';
+    if (num_lines == max) {
+      char **more = realloc(lines, (max = max ? 2 * max : 256)
+			    * sizeof(*lines));
+      if (!more)
+	goto out_of_memory;
+      lines = more;
+    }
+    if (!(lines[num_lines++] = strdup(buf)))
+      goto out_of_memory;
+  }
+  if (!(results = calloc(num_lines ? num_lines : 1, sizeof(*results))))
+    goto out_of_memory;
+
+  pthread_t *tid = malloc(nt * sizeof(*tid));
+  for (t = 1; tid && t < nt; t++)
+    if (pthread_create(&tid[t], NULL, boggle_worker, NULL))
+      break;
+  boggle_worker(NULL);
+  while (tid && --t > 0)
+    pthread_join(tid[t], NULL);
+  free(tid);
+
+  for (i = 0; i < num_lines; i++) {
+    if (!results[i])
+      goto out_of_memory;
+    puts(results[i]);
+  }
+  return 0;
+
+ out_of_memory:
+  fprintf(stderr, "(E) Out of memory\n");
+  return 6;
+}
+
+int boggle_main(int argc, char *argv[])
+{
+  struct solver s;
+  struct board b;
+  unsigned n;
+
+  if (argc > 2 && isdigit(argv[2][0])) {
+    min_len = atoi(argv[2]);
+    if (min_len < MIN_WORD_LEN)
+      min_len = MIN_WORD_LEN;
+  }
+  if (!(trie = vocab_trie())) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  /* The nodes are the root and the children of all nodes: */
+  for (num_nodes = 1, n = 0; n < num_nodes; n++)
+    num_nodes += __builtin_popcount(trie[n].mask);
+
+  if (!strcmp(argv[1], "-"))
+    return boggle_stream(stdin);
+
+  if (!parse_board(argv[1], &b)) {
+    fprintf(stderr, "(E) Expect rows of letters of the same length "
+	    "separated by /, at most %u letters: %s\n", MAX_CELLS, argv[1]);
+    return 3;
+  }
+  if (!solver_init(&s)) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  solve(&s, &b, 1);
+  fprintf(stderr, "%u words, score %d\n", s.count, s.score);
+  if (s.out_len) {
+    char *w;
+    for (w = strtok(s.out, " "); w; w = strtok(NULL, " "))
+      puts(w);
+  }
+  return 0;
+}
@@ -0,0 +1,438 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Crossword: fill all slots of a grid with words at once.
+
+   The operand is a file with the grid (- for stdin): # is a black square,
+   a letter is given and anything else is a square to fill. A slot is a run
+   of at least 2 white squares across or down; no word is used twice.
+
+   The domain of a slot is a bitset over the words of its length. Filling
+   a slot narrows the domains of the slots that cross it, with the
+   positional bitsets of vocab.c: the letters a slot still allows at a
+   square select the words of the crossing slot with one of those letters
+   there, and a narrowed domain is propagated further the same way. The
+   search fills the most constrained slot first: the one with the fewest
+   words left relative to how often its domain became empty before. It
+   tries first the words that leave the most words for the crossing
+   slots and backtracks when a domain becomes empty. The search restarts
+   with twice the node limit each time it reaches it, keeping what it
+   learned about the slots that fail. With more threads (-j) the other
+   threads try the words in a somewhat shuffled order; the first fill
+   found wins.
+*/
+
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define MAX_GRID  32			/* rows and columns at most */
+#define NO_SLOT   (~0u)
+
+static char grid[MAX_GRID][MAX_GRID];	/* # black, . open, or letter */
+static unsigned rows, cols;
+
+struct slot {
+  unsigned row, col, down, len;
+  unsigned nb;				/* bitwords of the domain */
+  unsigned offset;			/* of the domain in a set of domains */
+  unsigned cross[MAX_WORD_LEN];		/* slot crossing at each position */
+  unsigned cross_pos[MAX_WORD_LEN];	/* position in that slot */
+};
+static struct slot *slots;
+static unsigned num_slots;
+static unsigned domains_size;		/* bitwords for all domains */
+static bitword *initial;		/* domains given the letters */
+
+/* Search state of one thread: */
+struct filler {
+  unsigned seed;			/* 0: words in alphabetical order */
+  bitword *domains;			/* per depth all domains */
+  int *word;				/* per slot the word, -1 if open */
+  unsigned *queue;			/* slots to propagate from */
+  char *queued;
+  unsigned *weight;			/* per slot how often it failed */
+  unsigned long nodes, limit;		/* restart after limit nodes */
+};
+static int done;			/* set when the search is over */
+static struct filler *winner;
+
+static unsigned rnd(unsigned *seed)
+{
+  *seed = *seed * 1103515245u + 12345u;
+  return *seed >> 16;
+}
+
+static unsigned count_bits(const bitword *d, unsigned nb)
+{
+  return bits_and_count(d, d, nb);
+}
+
+/* The letters the words in domain d of slot s have at position pos. */
+static unsigned letters_at(const struct slot *s, const bitword *d,
+			   unsigned pos)
+{
+  unsigned c, i, mask = 0;
+  for (c = 0; c < 26; c++) {
+    const bitword *pb = vocab_posbits(s->len, pos, c);
+    for (i = 0; i < s->nb; i++)
+      if (d[i] & pb[i]) {
+	mask |= 1u << c;
+	break;
+      }
+  }
+  return mask;
+}
+
+/* Narrow the domains D from slot s on; returns 0 if one becomes empty. */
+static int propagate(struct filler *f, bitword *D, unsigned s)
+{
+  unsigned head = 0, tail = 0;
+  f->queue[tail++] = s;
+  f->queued[s] = 1;
+  while (head < tail) {
+    struct slot *S = &slots[f->queue[head]];
+    unsigned pos;
+    f->queued[f->queue[head++]] = 0;
+    for (pos = 0; pos < S->len; pos++) {
+      unsigned t = S->cross[pos];
+      if (t == NO_SLOT)
+	continue;
+      struct slot *T = &slots[t];
+      unsigned allowed = letters_at(S, D + S->offset, pos);
+      bitword *dt = D + T->offset, any = 0, changed = 0;
+      unsigned i, c, m, p = S->cross_pos[pos];
+      for (i = 0; i < T->nb; i++) {
+	bitword keep = 0;
+	for (m = allowed; m; m &= m-1) {
+	  c = __builtin_ctz(m);
+	  keep |= vocab_posbits(T->len, p, c)[i];
+	}
+	changed |= dt[i] & ~keep;
+	dt[i] &= keep;
+	any |= dt[i];
+      }
+      if (!any) {
+	f->weight[t]++;
+	return 0;
+      }
+      if (changed && !f->queued[t]) {
+	if (tail == num_slots) {
+	  /* Wrap around; at most num_slots are queued at a time: */
+	  memmove(f->queue, f->queue+head, (tail-head) * sizeof(*f->queue));
+	  tail -= head;
+	  head = 0;
+	}
+	f->queue[tail++] = t;
+	f->queued[t] = 1;
+      }
+    }
+  }
+  return 1;
+}
+
+struct option {
+  unsigned word;
+  float score;
+};
+
+static int option_cmp(const void *a, const void *b)
+{
+  const struct option *x = a, *y = b;
+  return x->score < y->score ? 1 : x->score > y->score ? -1 :
+	 x->word > y->word ? 1 : x->word < y->word ? -1 : 0;
+}
+
+/* Fill the open slots given the domains at depth. Returns 1 if done, 0
+   if there is no fill and -1 if the node limit was reached.
+*/
+static int solve(struct filler *f, unsigned depth)
+{
+  bitword *D = f->domains + depth * domains_size, *next = D + domains_size;
+  unsigned s, best = NO_SLOT, fewest = 0;
+
+  if (__atomic_load_n(&done, __ATOMIC_RELAXED))
+    return 0;
+  if (++f->nodes > f->limit)
+    return -1;
+  for (s = 0; s < num_slots; s++)
+    if (f->word[s] < 0) {
+      unsigned n = count_bits(D + slots[s].offset, slots[s].nb);
+      if (best == NO_SLOT || (unsigned long long) n * f->weight[best]
+			     < (unsigned long long) fewest * f->weight[s]) {
+	fewest = n;
+	best = s;
+      }
+    }
+  if (best == NO_SLOT)
+    return 1;
+
+  /* Per position and letter how many words the crossing slot keeps: */
+  struct slot *S = &slots[best];
+  float keep[MAX_WORD_LEN][26];
+  unsigned pos, c, i, k, n = 0;
+  for (pos = 0; pos < S->len; pos++) {
+    unsigned t = S->cross[pos];
+    for (c = 0; c < 26; c++)
+      keep[pos][c] = t == NO_SLOT ? 0 :
+	log2f(1 + bits_and_count(D + slots[t].offset,
+				 vocab_posbits(slots[t].len,
+					       S->cross_pos[pos], c),
+				 slots[t].nb));
+  }
+  /* Try first the words that leave the crossing slots the most words: */
+  struct option *options = malloc(fewest * sizeof(*options));
+  const bitword *d = D + S->offset;
+  const char **wl = vocab_words(S->len);
+  if (!options)
+    return 0;
+  for (i = 0; i < S->nb; i++) {
+    bitword m;
+    for (m = d[i]; m; m &= m-1) {
+      unsigned w = i * BITWORD_BITS + __builtin_ctzll(m);
+      float score = 0;
+      for (pos = 0; pos < S->len; pos++)
+	score += keep[pos][wl[w][pos]-'A'];
+      if (f->seed)
+	score += (rnd(&f->seed) % 1024) / 256.0f;
+      options[n].word = w;
+      options[n++].score = score;
+    }
+  }
+  qsort(options, n, sizeof(*options), option_cmp);
+
+  int result = 0;
+  for (k = 0; k < n && !result; k++) {
+    unsigned w = options[k].word, t;
+    /* No word twice: */
+    for (t = 0; t < num_slots; t++)
+      if (f->word[t] == (int) w && slots[t].len == S->len)
+	break;
+    if (t < num_slots)
+      continue;
+    memcpy(next, D, domains_size * sizeof(*D));
+    memset(next + S->offset, 0, S->nb * sizeof(*next));
+    next[S->offset + w / BITWORD_BITS] = 1ULL << (w % BITWORD_BITS);
+    f->word[best] = w;
+    if (propagate(f, next, best))
+      result = solve(f, depth+1);
+    if (result != 1)
+      f->word[best] = -1;
+  }
+  free(options);
+  return result;
+}
+
+/* Search with a node limit that doubles on each restart. */
+static void *fill_worker(void *arg)
+{
+  struct filler *f = arg;
+  int result;
+  f->limit = 128;
+  do {
+    unsigned s;
+    for (s = 0; s < num_slots; s++)
+      f->word[s] = -1;
+    memcpy(f->domains, initial, domains_size * sizeof(*initial));
+    f->nodes = 0;
+    f->limit *= 2;
+    result = solve(f, 0);
+  } while (result < 0);
+  /* A fill, or none at all, ends the search of all threads: */
+  if (!__atomic_exchange_n(&done, 1, __ATOMIC_RELAXED) && result == 1)
+    winner = f;
+  return NULL;
+}
+
+/* Read the grid from fp; returns 0 if it does not fit. */
+static int read_grid(FILE *fp)
+{
+  char buf[256];
+  while (fgets(buf, sizeof(buf), fp)) {
+    unsigned c;
+    buf[strcspn(buf, "\r\n")] = '\0';
+    if (!buf[0])
+      continue;
+    if (rows == MAX_GRID || strlen(buf) > MAX_GRID)
+      return 0;
+    for (c = 0; buf[c]; c++)
+      grid[rows][c] = buf[c] == '#' ? '#' :
+		      isalpha(buf[c]) ? toupper(buf[c]) : '.';
+    if (c > cols)
+      cols = c;
+    /* A short line ends in black squares: */
+    for (; c < MAX_GRID; c++)
+      grid[rows][c] = '#';
+    rows++;
+  }
+  return 1;
+}
+
+#define WHITE(r, c) ((r) < rows && (c) < cols && grid[r][c] != '#')
+
+/* Find the slots and their crossings; returns 0 if one is too long. */
+static int find_slots(void)
+{
+  static unsigned slot_at[MAX_GRID][MAX_GRID][2];
+  static unsigned pos_at[MAX_GRID][MAX_GRID][2];
+  unsigned r, c, dir, i;
+
+  slots = malloc(2 * rows * cols * sizeof(*slots));
+  if (!slots)
+    return 0;
+  for (r = 0; r < rows; r++)
+    for (c = 0; c < cols; c++)
+      slot_at[r][c][0] = slot_at[r][c][1] = NO_SLOT;
+  for (dir = 0; dir < 2; dir++)
+    for (r = 0; r < rows; r++)
+      for (c = 0; c < cols; c++) {
+	unsigned dr = dir, dc = !dir, len = 0;
+	if (!WHITE(r, c) || (r >= dr && c >= dc && WHITE(r-dr, c-dc)))
+	  continue;
+	while (WHITE(r + len*dr, c + len*dc))
+	  len++;
+	if (len < MIN_WORD_LEN)
+	  continue;
+	if (len > MAX_WORD_LEN) {
+	  fprintf(stderr, "(E) Slot of %u letters at row %u, column %u; "
+		  "words have at most %u\n", len, r+1, c+1, MAX_WORD_LEN);
+	  return 0;
+	}
+	struct slot *s = &slots[num_slots];
+	s->row = r;
+	s->col = c;
+	s->down = dir;
+	s->len = len;
+	s->nb = vocab_bitwords(len);
+	s->offset = domains_size;
+	domains_size += s->nb;
+	for (i = 0; i < len; i++) {
+	  slot_at[r + i*dr][c + i*dc][dir] = num_slots;
+	  pos_at[r + i*dr][c + i*dc][dir] = i;
+	}
+	num_slots++;
+      }
+  for (i = 0; i < num_slots; i++) {
+    struct slot *s = &slots[i];
+    unsigned pos;
+    for (pos = 0; pos < s->len; pos++) {
+      unsigned sr = s->row + pos * s->down, sc = s->col + pos * !s->down;
+      s->cross[pos] = slot_at[sr][sc][!s->down];
+      s->cross_pos[pos] = pos_at[sr][sc][!s->down];
+    }
+  }
+  return 1;
+}
+
+int crossword_main(int argc, char *argv[])
+{
+  unsigned i, t, nt = num_threads ? num_threads : 1;
+  FILE *fp = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin;
+
+  (void) argc;
+  if (!fp) {
+    fprintf(stderr, "(E) Cannot open grid file: %s\n", argv[1]);
+    return 3;
+  }
+  int ok = read_grid(fp);
+  if (fp != stdin)
+    fclose(fp);
+  if (!ok) {
+    fprintf(stderr, "(E) Expect a grid of at most %u by %u squares\n",
+	    MAX_GRID, MAX_GRID);
+    return 3;
+  }
+  if (!find_slots())
+    return 3;
+
+  /* Domains given the letters in the grid; this also builds the indexes
+     before the threads use them:
+  */
+  initial = malloc(domains_size * sizeof(*initial));
+  if (!initial) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (i = 0; i < num_slots; i++) {
+    struct slot *s = &slots[i];
+    bitword *d = initial + s->offset;
+    unsigned pos, j;
+    if (!vocab_posbits(s->len, 0, 0)) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    for (j = 0; j < s->nb; j++)
+      d[j] = ~0ULL;
+    if (vocab_count(s->len) % BITWORD_BITS)
+      d[s->nb-1] = (1ULL << (vocab_count(s->len) % BITWORD_BITS)) - 1;
+    for (pos = 0; pos < s->len; pos++) {
+      char ch = grid[s->row + pos * s->down][s->col + pos * !s->down];
+      if (ch != '.') {
+	const bitword *pb = vocab_posbits(s->len, pos, ch-'A');
+	for (j = 0; j < s->nb; j++)
+	  d[j] &= pb[j];
+      }
+    }
+  }
+  fprintf(stderr, "%u slots\n", num_slots);
+
+  struct filler *fillers = calloc(nt, sizeof(*fillers));
+  if (!fillers) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (t = 0; t < nt; t++) {
+    struct filler *f = &fillers[t];
+    f->seed = t * 2654435761u;
+    f->domains = malloc((size_t) (num_slots+1) * domains_size
+			* sizeof(*f->domains));
+    f->word = malloc(num_slots * sizeof(*f->word));
+    f->queue = malloc(num_slots * sizeof(*f->queue));
+    f->queued = calloc(num_slots, 1);
+    f->weight = malloc(num_slots * sizeof(*f->weight));
+    if (!f->domains || !f->word || !f->queue || !f->queued || !f->weight) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    for (i = 0; i < num_slots; i++)
+      f->weight[i] = 1;
+  }
+  /* Propagate the given letters once, for all: */
+  for (i = 0; i < num_slots; i++)
+    if (!propagate(&fillers[0], initial, i))
+      break;
+  if (i == num_slots) {
+    pthread_t *tid = malloc(nt * sizeof(*tid));
+    for (t = 1; tid && t < nt; t++)
+      if (pthread_create(&tid[t], NULL, fill_worker, &fillers[t]))
+	break;
+    fill_worker(&fillers[0]);
+    while (tid && --t > 0)
+      pthread_join(tid[t], NULL);
+    free(tid);
+  }
+  if (!winner) {
+    fprintf(stderr, "No fill found\n");
+    return 0;
+  }
+
+  for (i = 0; i < num_slots; i++) {
+    struct slot *s = &slots[i];
+    const char *w = vocab_words(s->len)[winner->word[i]];
+    unsigned pos;
+    for (pos = 0; pos < s->len; pos++)
+      grid[s->row + pos * s->down][s->col + pos * !s->down] = w[pos];
+  }
+  unsigned r, c;
+  for (r = 0; r < rows; r++) {
+    for (c = 0; c < cols; c++)
+      fputc(grid[r][c], stdout);
+    fputc('\n', stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,181 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Fuzzy lookup: the words within a small edit distance of a query.
+
+   The operand is the query word, optionally followed by the maximum
+   number of edits (default 2): letters inserted, deleted or substituted.
+   The words found are listed with their distance, closest first. With
+   operand - the queries are read from stdin, one per line, and the output
+   of each is followed by an empty line.
+
+   Rather than computing the distance to each word in turn, the trie of
+   the vocabulary is walked along with a Levenshtein automaton of the
+   query, simulated bit-parallel as described by Wu and Manber: for each
+   number of edits d a bitmask R[d] of the query positions that the path so
+   far can reach with d edits. A subtree is abandoned as soon as no
+   position can be reached with the edits allowed.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define MAX_EDITS 3
+#define MAX_QUERY 32			/* positions fit in a mask */
+
+typedef unsigned long long posmask;
+
+static const struct trie_node *trie;
+static unsigned max_edits = 2;
+
+/* The query being answered: */
+static unsigned qlen;
+static posmask match[26];		/* bit j+1: letter at query pos j */
+static unsigned letter[MAX_QUERY];	/* bit c: letter c at query pos j */
+static posmask all;			/* bits 0..qlen */
+static char word[MAX_WORD_LEN+1];	/* the path in the trie */
+
+struct suggestion {
+  unsigned dist;
+  char word[MAX_WORD_LEN+1];
+};
+static struct suggestion *found;
+static unsigned num_found, max_found;
+static int out_of_memory;
+
+static void suggest(unsigned len, unsigned dist)
+{
+  if (num_found == max_found) {
+    unsigned max = max_found ? 2 * max_found : 64;
+    struct suggestion *more = realloc(found, max * sizeof(*more));
+    if (!more) {
+      out_of_memory = 1;
+      return;
+    }
+    found = more;
+    max_found = max;
+  }
+  found[num_found].dist = dist;
+  memcpy(found[num_found].word, word, len);
+  found[num_found++].word[len] = '\0';
+}
+
+/* Visit trie node n at depth with R the states of the automaton. */
+static void walk(unsigned n, unsigned depth, const posmask R[])
+{
+  unsigned d, m, j;
+
+  if (trie[n].end)
+    for (d = 0; d <= max_edits; d++)
+      if ((R[d] >> qlen) & 1) {
+	suggest(depth, d);
+	break;
+      }
+  if (depth == MAX_WORD_LEN)
+    return;
+  m = trie[n].mask;
+  if (!max_edits || !R[max_edits-1]) {
+    /* No edits left: only the letters of the query can follow. */
+    unsigned next = 0;
+    posmask r;
+    for (r = R[max_edits] & (all >> 1); r; r &= r-1) {
+      j = __builtin_ctzll(r);
+      next |= letter[j];
+    }
+    m &= next;
+  }
+  for (; m; m &= m-1) {
+    unsigned c = __builtin_ctz(m);
+    posmask S[MAX_EDITS+1];
+    /* Match, then insertion, substitution and deletion: */
+    S[0] = (R[0] << 1) & match[c];
+    for (d = 1; d <= max_edits; d++)
+      S[d] = (((R[d] << 1) & match[c]) | R[d-1] | (R[d-1] << 1)
+	      | (S[d-1] << 1)) & all;
+    /* S[d] includes S[d-1], so S[max_edits] tells whether any is left: */
+    if (S[max_edits]) {
+      word[depth] = 'A'+c;
+      walk(trie_child(trie, n, c), depth+1, S);
+    }
+  }
+}
+
+static int suggestion_cmp(const void *a, const void *b)
+{
+  const struct suggestion *x = a, *y = b;
+  if (x->dist != y->dist)
+    return x->dist < y->dist ? -1 : 1;
+  return strcmp(x->word, y->word);
+}
+
+/* Answer one query; returns 0 if all is well. */
+static int lookup(const char *query, int verbose)
+{
+  posmask R[MAX_EDITS+1];
+  unsigned i, d;
+
+  qlen = strlen(query);
+  if (!qlen || qlen >= MAX_QUERY) {
+    fprintf(stderr, "(E) Expect a word of 1 to %u letters\n", MAX_QUERY-1);
+    return 3;
+  }
+  memset(match, 0, sizeof(match));
+  for (i = 0; i < qlen; i++) {
+    if (!isalpha(query[i])) {
+      fprintf(stderr, "(E) Expect only letters: %s\n", query);
+      return 3;
+    }
+    match[toupper(query[i])-'A'] |= 2ULL << i;
+    letter[i] = 1u << (toupper(query[i])-'A');
+  }
+  all = (2ULL << qlen) - 1;
+  /* Before any letter, d deletions reach query position d: */
+  R[0] = 1;
+  for (d = 1; d <= max_edits; d++)
+    R[d] = (R[d-1] | R[d-1] << 1) & all;
+
+  num_found = 0;
+  walk(0, 0, R);
+  if (out_of_memory) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  qsort(found, num_found, sizeof(*found), suggestion_cmp);
+  if (verbose)
+    fprintf(stderr, "%u words\n", num_found);
+  for (i = 0; i < num_found && (!max_results || i < max_results); i++)
+    printf("%s %u\n", found[i].word, found[i].dist);
+  return 0;
+}
+
+int fuzzy_main(int argc, char *argv[])
+{
+  if (argc > 2 && isdigit(argv[2][0])) {
+    max_edits = atoi(argv[2]);
+    if (max_edits > MAX_EDITS) {
+      fprintf(stderr, "(W) maximum distance (%u) too large; set to %u\n",
+	      max_edits, MAX_EDITS);
+      max_edits = MAX_EDITS;
+    }
+  }
+  if (!(trie = vocab_trie())) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  if (strcmp(argv[1], "-"))
+    return lookup(argv[1], 1);
+
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    char *query = strtok(line, " \t\r\n");
+    if (!query)
+      continue;
+    lookup(query, 0);
+    fputc('\n', stdout);
+  }
+  return 0;
+}
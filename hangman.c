@@ -0,0 +1,116 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Hangman: which letter to guess next.
+
+   The operand is a partial word like '.A..A.' with the letters revealed so
+   far and anything else for unknown positions; option -g gives the letters
+   already guessed, right or wrong. A revealed letter is revealed at all its
+   positions, so no guessed letter can be at an unknown position. The
+   candidates are therefore found in one pass of bitset operations on the
+   positional index. For each letter not guessed yet the number of
+   candidates having it is a population count of the candidates and the
+   words with that letter.
+
+   With operand - the queries are read from stdin, one per line as a
+   partial word optionally followed by the letters guessed, and the output
+   of each is followed by an empty line.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+/* Answer one query, telling the number of candidates on stderr if
+   verbose; returns 0 if all is well.
+*/
+static int recommend(const char *word, const char *guessed, int verbose)
+{
+  unsigned len = strlen(word), pos, c, i;
+  unsigned tried = 0;
+
+  if (len < MIN_WORD_LEN || len > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a word of %u to %u positions\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN);
+    return 3;
+  }
+  for (; *guessed; guessed++)
+    if (isalpha(*guessed))
+      tried |= 1u << (toupper(*guessed)-'A');
+  for (pos = 0; pos < len; pos++)
+    if (isalpha(word[pos]))
+      tried |= 1u << (toupper(word[pos])-'A');
+
+  unsigned nb = vocab_bitwords(len), n = vocab_count(len);
+  bitword *cand = malloc(nb * sizeof(*cand));
+  if (!cand || !vocab_posbits(len, 0, 0) || !vocab_letterbits(len, 0)) {
+    free(cand);
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (i = 0; i < nb; i++)
+    cand[i] = ~0ULL;
+  if (n % BITWORD_BITS)
+    cand[nb-1] = (1ULL << (n % BITWORD_BITS)) - 1;
+  for (pos = 0; pos < len; pos++) {
+    if (isalpha(word[pos])) {
+      const bitword *pb = vocab_posbits(len, pos, toupper(word[pos])-'A');
+      for (i = 0; i < nb; i++)
+	cand[i] &= pb[i];
+    }
+    else
+      for (c = 0; c < 26; c++)
+	if ((tried >> c) & 1) {
+	  const bitword *pb = vocab_posbits(len, pos, c);
+	  for (i = 0; i < nb; i++)
+	    cand[i] &= ~pb[i];
+	}
+  }
+
+  unsigned total = 0;
+  for (i = 0; i < nb; i++)
+    total += __builtin_popcountll(cand[i]);
+
+  /* Hits per letter not tried yet, listed most frequent first: */
+  unsigned hits[26], order[26], num = 0;
+  for (c = 0; c < 26; c++) {
+    if ((tried >> c) & 1)
+      continue;
+    hits[c] = bits_and_count(cand, vocab_letterbits(len, c), nb);
+    if (!hits[c])
+      continue;
+    for (i = num++; i > 0 && hits[order[i-1]] < hits[c]; i--)
+      order[i] = order[i-1];
+    order[i] = c;
+  }
+  if (verbose)
+    fprintf(stderr, "%u candidate%s\n", total, total == 1 ? "" : "s");
+  if (max_results && num > max_results)
+    num = max_results;
+  for (i = 0; i < num; i++)
+    printf("%c %u %.4f\n", order[i]+'A', hits[order[i]],
+	   (double) hits[order[i]] / total);
+  free(cand);
+  return 0;
+}
+
+int hangman_main(int argc, char *argv[])
+{
+  (void) argc;
+  if (strcmp(argv[1], "-"))
+    return recommend(argv[1], hangman_guessed, 1);
+
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    char *word = strtok(line, " \t\r\n");
+    if (!word)
+      continue;
+    char *guessed = strtok(NULL, " \t\r\n");
+    recommend(word, guessed ? guessed : hangman_guessed, 0);
+    fputc('\n', stdout);
+  }
+  return 0;
+}
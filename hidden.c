@@ -0,0 +1,148 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Hidden words: all words that occur in a text as a run of its letters.
+
+   The operand is the text, optionally followed by the minimum word length
+   (default 3). With operand - the text is read from stdin. Each word found
+   is written with its offset in the text (counting from 0), in the order
+   in which the words end, the longest first. Anything but a letter breaks
+   a word; case does not matter.
+
+   The text is scanned once by an Aho-Corasick automaton made from the
+   trie of the vocabulary: the state after each letter is the trie node of
+   the longest word prefix the text ends in. The failure links (the next
+   shorter such prefix) are folded into a full transition table of 26
+   states per node, so each letter costs one table lookup, and per node a
+   link to the next word that ends there lists the words found.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define KEEP (MAX_WORD_LEN-1)		/* letters kept from a block of input */
+
+static const struct trie_node *trie;
+static unsigned min_len = 3;
+
+/* The automaton: */
+static unsigned *next;			/* per node 26 states */
+static unsigned *out;			/* per node: next word end, 0 if none */
+static unsigned char *depth;		/* per node: length of its prefix */
+
+/* Build the automaton in breadth-first order of the trie, so the failure
+   state of a node is complete before the node itself. Returns 0 if out of
+   memory.
+*/
+static int build_automaton(void)
+{
+  unsigned num_nodes, n, head, tail, c;
+  unsigned *fail, *queue;
+
+  if (!(trie = vocab_trie()))
+    return 0;
+  for (num_nodes = 1, n = 0; n < num_nodes; n++)
+    num_nodes += __builtin_popcount(trie[n].mask);
+  next = malloc(num_nodes * 26 * sizeof(*next));
+  out = malloc(num_nodes * sizeof(*out));
+  depth = malloc(num_nodes);
+  fail = malloc(num_nodes * sizeof(*fail));
+  queue = malloc(num_nodes * sizeof(*queue));
+  if (!next || !out || !depth || !fail || !queue) {
+    free(fail);
+    free(queue);
+    return 0;
+  }
+  fail[0] = out[0] = depth[0] = 0;
+  queue[0] = 0;
+  for (head = 0, tail = 1; head < tail; head++) {
+    unsigned u = queue[head];
+    for (c = 0; c < 26; c++) {
+      if ((trie[u].mask >> c) & 1) {
+	unsigned v = trie_child(trie, u, c);
+	/* The longest proper suffix that is a prefix: */
+	fail[v] = u ? next[fail[u]*26 + c] : 0;
+	out[v] = trie[fail[v]].end ? fail[v] : out[fail[v]];
+	depth[v] = depth[u]+1;
+	next[u*26 + c] = v;
+	queue[tail++] = v;
+      }
+      else
+	next[u*26 + c] = u ? next[fail[u]*26 + c] : 0;
+    }
+  }
+  free(fail);
+  free(queue);
+  return 1;
+}
+
+/* Scan the characters of text from start to n, where text starts at
+   offset in the input; *state carries the automaton over from the text
+   before start, at least MAX_WORD_LEN-1 characters of which must be in
+   text. Returns the number of words found.
+*/
+static unsigned long scan(const char *text, size_t start, size_t n,
+			  unsigned long offset, unsigned *state)
+{
+  unsigned long found = 0;
+  unsigned s = *state, m, i;
+  size_t pos;
+
+  for (pos = start; pos < n; pos++) {
+    unsigned c = (text[pos] & ~0x20) - 'A';
+    if (c >= 26) {
+      s = 0;
+      continue;
+    }
+    s = next[s*26 + c];
+    /* The words ending here, longest first: */
+    m = trie[s].end ? s : out[s];
+    for (; m && depth[m] >= min_len; m = out[m]) {
+      size_t from = pos+1 - depth[m];
+      printf("%lu ", offset + from);
+      for (i = 0; i < depth[m]; i++)
+	putchar(toupper(text[from+i]));
+      putchar('\n');
+      found++;
+    }
+  }
+  *state = s;
+  return found;
+}
+
+int hidden_main(int argc, char *argv[])
+{
+  unsigned long found = 0;
+  unsigned state = 0;
+
+  if (argc > 2 && isdigit(argv[2][0])) {
+    min_len = atoi(argv[2]);
+    if (min_len < MIN_WORD_LEN)
+      min_len = MIN_WORD_LEN;
+  }
+  if (!build_automaton()) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  if (strcmp(argv[1], "-"))
+    found = scan(argv[1], 0, strlen(argv[1]), 0, &state);
+  else {
+    /* The last letters of a block are kept for a word that goes on in
+       the next one: */
+    static char buf[KEEP + (1 << 16)];
+    unsigned long offset = 0;
+    size_t n;
+    memset(buf, ' ', KEEP);
+    while ((n = fread(buf + KEEP, 1, sizeof(buf) - KEEP, stdin)) > 0) {
+      found += scan(buf, KEEP, KEEP+n, offset - KEEP, &state);
+      offset += n;
+      memmove(buf, buf + n, KEEP);
+    }
+  }
+  fprintf(stderr, "%lu words\n", found);
+  return 0;
+}
@@ -0,0 +1,191 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Hints: the words of a rack, restricted in length and letters, as asked
+   for during a game.
+
+   The first operand is the rack; the others are queries, or if there are
+   none the queries are read from stdin, one per line. A query is a length
+   and/or a letter: 5 asks for the words of 5 letters, S for those that
+   start with S, +S for those that have an S, and 5S and 5+S combine these;
+   * asks for all words. Each query gets one line of output with its words,
+   by length and then alphabetically.
+
+   The rack is worked out once: its distinct sub-multisets that are word
+   signatures are found in the signature trie (vocab_subsignatures()) and
+   their anagrams in the signature index. The words are kept sorted on
+   length and then alphabetically, so those of a length that start with a
+   letter are a range; per length and letter another list holds the words
+   that have the letter. A query thus takes time in proportion to its
+   answer (plus one range per length if the length is not given).
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define SLOT(len, c) ((len) * 26 + (c))
+#define NUM_SLOTS SLOT(MAX_WORD_LEN+1, 0)
+
+/* The words of the rack: */
+static const char **words;
+static unsigned num_words;
+/* Per length and letter: the range of words that start with the letter,
+   and that of the words in with[] that have it.
+*/
+static unsigned first[NUM_SLOTS+1];
+static unsigned *with;
+static unsigned with_start[NUM_SLOTS+1];
+
+static int word_cmp(const void *a, const void *b)
+{
+  const char *x = *(const char **) a, *y = *(const char **) b;
+  size_t lx = strlen(x), ly = strlen(y);
+  if (lx != ly)
+    return lx < ly ? -1 : 1;
+  return strcmp(x, y);
+}
+
+/* Find the words of the rack; returns 0 if out of memory. */
+static int build(const unsigned count[26], unsigned len)
+{
+  static sigkey sigs[1 << MAX_WORD_LEN];
+  static unsigned char lens[1 << MAX_WORD_LEN];
+  unsigned i, j, k, n, c;
+  int num;
+
+  if (!vocab_signature_trie())
+    return 0;
+  num = vocab_subsignatures(count, MIN_WORD_LEN, len, -1, sigs, lens,
+			    &num_words);
+  words = malloc((num_words+1) * sizeof(*words));
+  with = malloc((num_words * len + 1) * sizeof(*with));
+  if (num < 0 || !words || !with)
+    return 0;
+  for (i = k = 0; i < (unsigned) num; i++) {
+    const unsigned *w = vocab_anagrams(lens[i], sigs[i], &n);
+    if (!w)
+      return 0;
+    for (j = 0; j < n; j++)
+      words[k++] = vocab_words(lens[i])[w[j]];
+  }
+  qsort(words, num_words, sizeof(*words), word_cmp);
+
+  /* Count per slot, then turn the counts into starts: */
+  for (i = 0; i < num_words; i++) {
+    unsigned l = strlen(words[i]), seen = 0;
+    first[SLOT(l, words[i][0]-'A') + 1]++;
+    for (j = 0; j < l; j++) {
+      c = words[i][j]-'A';
+      if (!((seen >> c) & 1))
+	with_start[SLOT(l, c) + 1]++;
+      seen |= 1u << c;
+    }
+  }
+  for (i = 1; i <= NUM_SLOTS; i++) {
+    first[i] += first[i-1];
+    with_start[i] += with_start[i-1];
+  }
+  /* Fill in with[], using the starts as cursors and restoring them: */
+  for (i = 0; i < num_words; i++) {
+    unsigned l = strlen(words[i]), seen = 0;
+    for (j = 0; j < l; j++) {
+      c = words[i][j]-'A';
+      if (!((seen >> c) & 1))
+	with[with_start[SLOT(l, c)]++] = i;
+      seen |= 1u << c;
+    }
+  }
+  for (i = NUM_SLOTS; i > 0; i--)
+    with_start[i] = with_start[i-1];
+  with_start[0] = 0;
+  return 1;
+}
+
+/* Answer one query; returns 0 if it is malformed. */
+static int hint(const char *query)
+{
+  unsigned len = 0, l, lo, hi, c = 26, i, n = 0;
+  int has = 0;
+  char *end;
+
+  if (isdigit(*query)) {
+    len = strtoul(query, &end, 10);
+    if (len < MIN_WORD_LEN || len > MAX_WORD_LEN)
+      return 0;
+    query = end;
+  }
+  if (*query == '+') {
+    has = 1;
+    query++;
+  }
+  if (isalpha(*query))
+    c = toupper(*query++)-'A';
+  else if (has)
+    return 0;
+  else if (!len) {
+    if (*query != '*')
+      return 0;
+    query++;
+  }
+  if (*query)
+    return 0;
+
+  for (l = len ? len : MIN_WORD_LEN; l <= (len ? len : MAX_WORD_LEN); l++) {
+    if (has) {
+      for (i = with_start[SLOT(l, c)]; i < with_start[SLOT(l, c) + 1]; i++)
+	printf(n++ ? " %s" : "%s", words[with[i]]);
+      continue;
+    }
+    lo = first[SLOT(l, c < 26 ? c : 0)];
+    hi = first[SLOT(l, c < 26 ? c+1 : 26)];
+    for (i = lo; i < hi; i++)
+      printf(n++ ? " %s" : "%s", words[i]);
+  }
+  putchar('\n');
+  return 1;
+}
+
+int hint_main(int argc, char *argv[])
+{
+  unsigned count[26] = { 0 }, len = strlen(argv[1]), i;
+
+  if (!len || len > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a rack of 1 to %u letters\n", MAX_WORD_LEN);
+    return 3;
+  }
+  for (i = 0; i < len; i++) {
+    if (!isalpha(argv[1][i])) {
+      fprintf(stderr, "(E) Expect only letters: %s\n", argv[1]);
+      return 3;
+    }
+    count[toupper(argv[1][i])-'A']++;
+  }
+  if (!build(count, len)) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  fprintf(stderr, "%u words\n", num_words);
+
+  if (argc > 2) {
+    for (i = 2; i < (unsigned) argc; i++)
+      if (!hint(argv[i])) {
+	fprintf(stderr, "(E) Expect a query like 5, S, +S, 5S, 5+S or *: "
+		"%s\n", argv[i]);
+	return 3;
+      }
+    return 0;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    char *query = strtok(line, " \t\r\n");
+    if (!query)
+      continue;
+    if (!hint(query))
+      fprintf(stderr, "(W) Ignored malformed query: %s\n", query);
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Isomorphs: words with the same pattern of repeated letters.
+
+   The operand is a pattern like ABCA or the enciphered word of a
+   cryptogram like XQJX: equal characters stand for equal letters and
+   different characters for different letters. It may be followed by a
+   template (see template.h) with the letters known so far, e.g. T..T.
+
+   The words of each length are indexed on their isomorph key (see
+   vocab.h), so a query is a hash lookup of the key of the pattern plus a
+   match of the template against the words found.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "template.h"
+#include "vocab.h"
+#include "words.h"
+
+static struct dfa tpl;
+
+int isomorph_main(int argc, char *argv[])
+{
+  const char *pattern = argv[1], *msg;
+  unsigned len = strlen(pattern), n, i, shown = 0;
+
+  if (len < MIN_WORD_LEN || len > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a pattern of %u to %u characters: %s\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN, pattern);
+    return 3;
+  }
+  if (argc > 2 && (msg = dfa_compile(&tpl, argv[2]))) {
+    fprintf(stderr, "(E) %s: %s\n", msg, argv[2]);
+    return 3;
+  }
+
+  const unsigned *iso = vocab_isomorphs(len,
+					vocab_isomorph_key(pattern, len), &n);
+  const char **wl = vocab_words(len);
+  if (!iso) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (i = 0; i < n; i++)
+    if (argc <= 2 || dfa_match(&tpl, wl[iso[i]])) {
+      puts(wl[iso[i]]);
+      shown++;
+    }
+  fprintf(stderr, "%u words\n", shown);
+  return 0;
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Word ladders: change one letter at a time to get from one word to
+   another, each step a word.
+
+   The operands are the first and the last word, of the same length; the
+   shortest ladder between them is printed, one word per line. With only
+   one operand its neighbours, the words one letter away, are listed.
+
+   The neighbours come from the wildcard buckets of vocab.c: per word and
+   position the word with that position blanked, e.g. C.T for CAT, COT and
+   CUT, so the neighbours of a word are the other words of its buckets. A
+   breadth-first search over them finds the shortest ladder.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+/* The index of word of length len in the vocabulary, -1 if not in it. */
+static int word_index(const char *word, unsigned len)
+{
+  unsigned lo, hi;
+  if (!vocab_prefix_range(len, word, len, &lo, &hi))
+    return -1;
+  return lo;
+}
+
+/* Upper-case the operand into word; returns its length, 0 if invalid. */
+static unsigned get_word(const char *arg, char word[MAX_WORD_LEN+1])
+{
+  unsigned len = strlen(arg), i;
+  if (len < MIN_WORD_LEN || len > MAX_WORD_LEN)
+    return 0;
+  for (i = 0; i <= len; i++)
+    word[i] = toupper(arg[i]);
+  return len;
+}
+
+int ladder_main(int argc, char *argv[])
+{
+  char from[MAX_WORD_LEN+1], to[MAX_WORD_LEN+1];
+  unsigned len = get_word(argv[1], from), adj[MAX_NEIGHBOURS], i;
+  int f, t = -1, n;
+
+  if (!len || (f = word_index(from, len)) < 0) {
+    fprintf(stderr, "(E) Not a word in the vocabulary: %s\n", argv[1]);
+    return 3;
+  }
+  if (argc > 2) {
+    if (get_word(argv[2], to) != len) {
+      fprintf(stderr, "(E) Expect two words of the same length\n");
+      return 3;
+    }
+    if ((t = word_index(to, len)) < 0) {
+      fprintf(stderr, "(E) Not a word in the vocabulary: %s\n", argv[2]);
+      return 3;
+    }
+  }
+  const char **wl = vocab_words(len);
+
+  if (t < 0) {
+    if ((n = vocab_neighbours(len, f, adj)) < 0) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    fprintf(stderr, "%d neighbours\n", n);
+    for (i = 0; i < (unsigned) n; i++)
+      puts(wl[adj[i]]);
+    return 0;
+  }
+
+  /* Breadth-first from the last word, so the ladder is read off forward: */
+  unsigned count = vocab_count(len), head = 0, tail = 0;
+  int *parent = malloc(count * sizeof(*parent));
+  unsigned *queue = malloc(count * sizeof(*queue));
+  if (!parent || !queue) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (i = 0; i < count; i++)
+    parent[i] = -1;
+  parent[t] = t;
+  queue[tail++] = t;
+  while (head < tail && parent[f] < 0) {
+    unsigned w = queue[head++];
+    if ((n = vocab_neighbours(len, w, adj)) < 0) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    for (i = 0; i < (unsigned) n; i++)
+      if (parent[adj[i]] < 0) {
+	parent[adj[i]] = w;
+	queue[tail++] = adj[i];
+      }
+  }
+  if (parent[f] < 0) {
+    fprintf(stderr, "No ladder from %s to %s\n", from, to);
+    return 0;
+  }
+  unsigned steps = 0;
+  for (i = f; i != (unsigned) t; i = parent[i], steps++)
+    puts(wl[i]);
+  puts(wl[t]);
+  fprintf(stderr, "%u steps\n", steps);
+  free(parent);
+  free(queue);
+  return 0;
+}
@@ -0,0 +1,209 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Level generator: racks for games like Words of Wonder, in which the
+   player finds the words made from some of the letters of a rack.
+
+   The operands are the rack size and the range of the number of answers
+   like 10-20 (or 10 for at least 10), optionally followed by the range of
+   answer lengths (default 3 up to the size). The candidate racks are the
+   letters of the words of that size, so each level has a word that uses
+   all letters. A rack is a level if the number of its words in the length
+   range is within the answer range. Per level a line is written with the
+   rack, the number of answers and the answers, shortest first; -n limits
+   the number of levels.
+
+   The answers of a rack are found by walking the signature trie (see
+   vocab.h) over the sub-multisets of the rack, each once as its letters
+   in alphabetical order (vocab_subsignatures()); a rack is rejected as
+   soon as it has too many answers. Only the racks that are levels look up
+   their words in the signature index. The racks are divided over the
+   threads (-j).
+*/
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+static unsigned size;
+static unsigned min_answers, max_answers = -1;
+static unsigned min_len = 3, max_len;
+
+/* The candidate racks (as the index of a word of the size) and the lines
+   of output for those that are levels:
+*/
+static unsigned *racks;
+static char **results;
+static unsigned num_racks;
+static unsigned next_rack;
+static int out_of_memory;
+
+/* Per thread: the signatures of the answers of a rack. */
+struct answers {
+  sigkey sigs[1 << MAX_WORD_LEN];
+  unsigned char lens[1 << MAX_WORD_LEN];
+};
+
+static int word_cmp(const void *a, const void *b)
+{
+  const char *x = *(const char **) a, *y = *(const char **) b;
+  size_t lx = strlen(x), ly = strlen(y);
+  if (lx != ly)
+    return lx < ly ? -1 : 1;
+  return strcmp(x, y);
+}
+
+/* The line for the rack of the letters of word, or NULL if the rack is no
+   level or if out of memory (then out_of_memory is set).
+*/
+static char *level(struct answers *a, const char *word)
+{
+  unsigned count[26] = { 0 }, i, j, k, n, c, words;
+  const char **list;
+  char *line, *p;
+  int num;
+
+  for (i = 0; i < size; i++)
+    count[word[i]-'A']++;
+  num = vocab_subsignatures(count, min_len, max_len, max_answers, a->sigs,
+			    a->lens, &words);
+  if (num < 0 || words < min_answers)
+    return NULL;
+
+  /* A level: now the answers themselves. */
+  list = malloc(words * sizeof(*list));
+  line = malloc(size + 12 + words * (max_len+1) + 1);
+  if (!list || !line)
+    goto out_of_memory;
+  for (i = k = 0; i < (unsigned) num; i++) {
+    const unsigned *w = vocab_anagrams(a->lens[i], a->sigs[i], &n);
+    if (!w)
+      goto out_of_memory;
+    for (j = 0; j < n; j++)
+      list[k++] = vocab_words(a->lens[i])[w[j]];
+  }
+  qsort(list, k, sizeof(*list), word_cmp);
+  /* The rack in alphabetical order: */
+  for (p = line, c = 0; c < 26; c++)
+    for (i = 0; i < count[c]; i++)
+      *p++ = 'A'+c;
+  p += sprintf(p, " %u", k);
+  for (i = 0; i < k; i++)
+    p += sprintf(p, " %s", list[i]);
+  free(list);
+  return line;
+
+ out_of_memory:
+  out_of_memory = 1;
+  free(list);
+  free(line);
+  return NULL;
+}
+
+static void *level_worker(void *arg)
+{
+  struct answers *a = malloc(sizeof(*a));
+  const char **wl = vocab_words(size);
+  unsigned i;
+  (void) arg;
+  if (!a) {
+    out_of_memory = 1;
+    return NULL;
+  }
+  while ((i = __atomic_fetch_add(&next_rack, 1, __ATOMIC_RELAXED))
+	 < num_racks)
+    results[i] = level(a, wl[racks[i]]);
+  free(a);
+  return NULL;
+}
+
+/* Parse a range like 10-20 or 10 (no maximum); returns 0 if malformed. */
+static int parse_range(const char *spec, unsigned *min, unsigned *max)
+{
+  char *end;
+  *min = strtoul(spec, &end, 10);
+  if (end == spec)
+    return 0;
+  if (*end == '-') {
+    spec = end+1;
+    *max = strtoul(spec, &end, 10);
+    if (end == spec || *max < *min)
+      return 0;
+  }
+  return !*end;
+}
+
+int level_main(int argc, char *argv[])
+{
+  unsigned i, t, n, levels = 0, nt = num_threads ? num_threads : 1;
+
+  size = atoi(argv[1]);
+  if (size < MIN_WORD_LEN || size > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a rack size of %u to %u\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN);
+    return 3;
+  }
+  max_len = size;
+  if (argc < 3 || !parse_range(argv[2], &min_answers, &max_answers)) {
+    fprintf(stderr, "(E) Expect a number of answers like 10-20\n");
+    return 3;
+  }
+  if (argc > 3 && (!parse_range(argv[3], &min_len, &max_len)
+		   || min_len > size)) {
+    fprintf(stderr, "(E) Expect answer lengths like 3-%u\n", size);
+    return 3;
+  }
+  if (min_len < MIN_WORD_LEN)
+    min_len = MIN_WORD_LEN;
+  if (max_len > size)
+    max_len = size;
+
+  /* The candidates: one word per signature of the size. */
+  const char **wl = vocab_words(size);
+  if (!vocab_signature_trie()
+      || !(racks = malloc(vocab_count(size) * sizeof(*racks))))
+    goto out_of_memory;
+  for (i = 0; i < vocab_count(size); i++) {
+    const unsigned *w = vocab_anagrams(size, vocab_signature(wl[i], size),
+				       &n);
+    if (!w)
+      goto out_of_memory;
+    if (w[0] == i)
+      racks[num_racks++] = i;
+  }
+  /* The signature index is built before the threads use it: */
+  for (i = min_len; i <= max_len; i++)
+    if (!vocab_anagrams(i, 0, &n))
+      goto out_of_memory;
+  if (!(results = calloc(num_racks ? num_racks : 1, sizeof(*results))))
+    goto out_of_memory;
+
+  pthread_t *tid = malloc(nt * sizeof(*tid));
+  for (t = 1; tid && t < nt; t++)
+    if (pthread_create(&tid[t], NULL, level_worker, NULL))
+      break;
+  level_worker(NULL);
+  while (tid && --t > 0)
+    pthread_join(tid[t], NULL);
+  free(tid);
+  if (out_of_memory)
+    goto out_of_memory;
+
+  for (i = 0; i < num_racks; i++)
+    if (results[i]) {
+      if (!max_results || levels < max_results)
+	puts(results[i]);
+      levels++;
+      free(results[i]);
+    }
+  fprintf(stderr, "%u levels of %u racks\n", levels, num_racks);
+  return 0;
+
+ out_of_memory:
+  fprintf(stderr, "(E) Out of memory\n");
+  return 6;
+}
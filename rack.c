@@ -0,0 +1,121 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Rack neighbours: the anagrams of a rack, of the rack with one letter
+   added and of the rack with one letter removed.
+
+   The operand is the rack. The first line of output (=) lists the words
+   that use exactly its letters; then a line +L for each letter L that
+   added to the rack gives words, and a line -L for each letter L of the
+   rack that removed from it gives words. With operand - the racks are read
+   from stdin, one per line, and the output of each is followed by an
+   empty line.
+
+   The words are found in the signature index of the vocabulary (see
+   vocab.h): the signature of the rack with a letter added or removed is
+   made from its letter counts, so each of these queries is a single
+   binary search.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+/* Signature of the letters counted in count. */
+static sigkey count_signature(const unsigned count[26])
+{
+  sigkey sig = 0;
+  unsigned c, i;
+  for (c = 0; c < 26; c++)
+    for (i = 0; i < count[c]; i++)
+      sig = sig << 5 | (c+1);
+  return sig;
+}
+
+/* Print the anagrams of the letters in count after tag; returns -1 if out
+   of memory, else their number.
+*/
+static int anagrams(const char *tag, const unsigned count[26], unsigned len)
+{
+  const char **wl;
+  const unsigned *words;
+  unsigned n, i;
+
+  if (len < MIN_WORD_LEN || len > MAX_WORD_LEN)
+    return 0;
+  if (!(words = vocab_anagrams(len, count_signature(count), &n)))
+    return -1;
+  if (!n)
+    return 0;
+  wl = vocab_words(len);
+  fputs(tag, stdout);
+  for (i = 0; i < n; i++)
+    printf(" %s", wl[words[i]]);
+  putchar('\n');
+  return n;
+}
+
+/* Answer one rack; returns 0 if all is well. */
+static int neighbours(const char *rack)
+{
+  unsigned count[26] = { 0 }, len = strlen(rack), c;
+  char tag[3] = "=";
+
+  if (!len || len > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a rack of 1 to %u letters\n", MAX_WORD_LEN);
+    return 3;
+  }
+  for (c = 0; c < len; c++) {
+    if (!isalpha(rack[c])) {
+      fprintf(stderr, "(E) Expect only letters: %s\n", rack);
+      return 3;
+    }
+    count[toupper(rack[c])-'A']++;
+  }
+  if (anagrams(tag, count, len) < 0)
+    goto out_of_memory;
+  /* One more letter: */
+  tag[0] = '+';
+  for (c = 0; c < 26; c++) {
+    tag[1] = 'A'+c;
+    count[c]++;
+    if (anagrams(tag, count, len+1) < 0)
+      goto out_of_memory;
+    count[c]--;
+  }
+  /* One letter less: */
+  tag[0] = '-';
+  for (c = 0; c < 26; c++)
+    if (count[c]) {
+      tag[1] = 'A'+c;
+      count[c]--;
+      if (anagrams(tag, count, len-1) < 0)
+	goto out_of_memory;
+      count[c]++;
+    }
+  return 0;
+
+ out_of_memory:
+  fprintf(stderr, "(E) Out of memory\n");
+  return 6;
+}
+
+int rack_main(int argc, char *argv[])
+{
+  (void) argc;
+  if (strcmp(argv[1], "-"))
+    return neighbours(argv[1]);
+
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    char *rack = strtok(line, " \t\r\n");
+    if (!rack)
+      continue;
+    if (neighbours(rack) == 6)
+      return 6;
+    fputc('\n', stdout);
+  }
+  return 0;
+}
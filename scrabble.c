@@ -0,0 +1,410 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Scrabble: all moves a rack allows on a board, with their scores.
+
+   The operands are a file with the board (- for stdin) and the rack, in
+   which ? is a blank. The board has 15 lines of 15 squares: a letter is a
+   tile (lower-case for a blank), anything else an empty square. Moves are
+   listed on decreasing score as 8H WORD 24 for a word across starting in
+   row 8, column H, and as H8 WORD 24 for a word down; letters of blanks
+   are shown in lower-case. -n limits the number of moves listed.
+
+   Moves are generated the way Appel and Jacobson describe: per row (and
+   per column, as rows of the transposed board) words are built from each
+   anchor, an empty square next to a tile, by walking a trie of the words.
+   The part left of an anchor only uses the squares up to the previous
+   anchor, so each move is found once. A square only takes the letters of
+   its cross-check mask, i.e., the letters that make a word with the tiles
+   above and below it; the masks are computed once per direction. The rack
+   is kept as counts per letter and blanks, like howmany[] in words.c.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+#define SIZE        15			/* squares per row and column */
+#define CENTRE      7			/* the first move covers this square */
+#define RACK_SIZE   7			/* using all tiles earns the bonus */
+#define BINGO       50
+#define ALL_LETTERS ((1u << 26) - 1)
+
+/* Premium squares: d(ouble), t(riple) letter and D(ouble), T(riple) word.
+   The layout is symmetric in its diagonal, so it holds for the transposed
+   board too.
+*/
+static const char premium[SIZE][SIZE+1] = {
+  "T..d...T...d..T",
+  ".D...t...t...D.",
+  "..D...d.d...D..",
+  "d..D...d...D..d",
+  "....D.....D....",
+  ".t...t...t...t.",
+  "..d...d.d...d..",
+  "T..d...D...d..T",
+  "..d...d.d...d..",
+  ".t...t...t...t.",
+  "....D.....D....",
+  "d..D...d...D..d",
+  "..D...d.d...D..",
+  ".D...t...t...D.",
+  "T..d...T...d..T",
+};
+
+static const struct trie_node *trie;
+static char board[SIZE][SIZE];		/* 0: empty, else the tile */
+static char grid[SIZE][SIZE];		/* board, transposed for down */
+static int down;			/* 1 if grid is transposed */
+static int empty_board;
+/* Per square of grid the letters that fit in the word across the row and
+   the value of the tiles of that word, -1 if there is no such word:
+*/
+static unsigned cross[SIZE][SIZE];
+static int cross_sum[SIZE][SIZE];
+
+static unsigned howmany[26];		/* multiplicity of each rack letter */
+static unsigned blanks;			/* number of blanks on the rack */
+
+/* The row being filled in: its tiles plus the letters placed so far. */
+static unsigned row, anchor;
+static char line[SIZE];
+static char placed[SIZE];		/* 1 if line[col] is from the rack */
+static char left[SIZE];			/* part left of the anchor */
+
+struct move {
+  unsigned char row, col, down;
+  int score;
+  char word[SIZE+1];
+};
+static struct move *moves;
+static unsigned num_moves, max_moves;
+static int out_of_memory;
+
+static int value(char tile)
+{
+  return islower(tile) ? 0 : letter_value[tile-'A'];
+}
+
+/* Follow the tile from node *n; returns 0 if no word continues so. */
+static int walk(unsigned *n, char tile)
+{
+  unsigned c = toupper(tile)-'A';
+  if (!((trie[*n].mask >> c) & 1))
+    return 0;
+  *n = trie_child(trie, *n, c);
+  return 1;
+}
+
+static int is_anchor(unsigned r, unsigned c)
+{
+  if (grid[r][c])
+    return 0;
+  if (empty_board)
+    return r == CENTRE && c == CENTRE;
+  return (r > 0 && grid[r-1][c]) || (r+1 < SIZE && grid[r+1][c])
+      || (c > 0 && grid[r][c-1]) || (c+1 < SIZE && grid[r][c+1]);
+}
+
+/* Compute the cross-check masks and sums of grid. */
+static void cross_checks(void)
+{
+  unsigned r, c, i;
+  for (r = 0; r < SIZE; r++)
+    for (c = 0; c < SIZE; c++) {
+      unsigned top = r, bottom = r+1, n = 0, m;
+      int sum = 0, ok = 1;
+      cross[r][c] = 0;
+      cross_sum[r][c] = -1;
+      if (grid[r][c])
+	continue;
+      while (top > 0 && grid[top-1][c])
+	top--;
+      while (bottom < SIZE && grid[bottom][c])
+	bottom++;
+      if (top == r && bottom == r+1) {
+	cross[r][c] = ALL_LETTERS;
+	continue;
+      }
+      for (i = top; i < r; i++) {
+	sum += value(grid[i][c]);
+	ok = ok && walk(&n, grid[i][c]);
+      }
+      for (i = r+1; i < bottom; i++)
+	sum += value(grid[i][c]);
+      cross_sum[r][c] = sum;
+      if (!ok)
+	continue;
+      for (m = trie[n].mask; m; m &= m-1) {
+	unsigned l = __builtin_ctz(m), k = trie_child(trie, n, l);
+	for (i = r+1; i < bottom && walk(&k, grid[i][c]); i++)
+	  ;
+	if (i == bottom && trie[k].end)
+	  cross[r][c] |= 1u << l;
+      }
+    }
+}
+
+/* Record the word line[start..end) as a move, with its score. */
+static void record(unsigned start, unsigned end)
+{
+  unsigned c, tiles = 0;
+  int sum = 0, mult = 1, extra = 0;
+
+  for (c = start; c < end; c++) {
+    int v = value(line[c]), lm = 1, wm = 1;
+    if (!placed[c]) {
+      sum += v;
+      continue;
+    }
+    tiles++;
+    switch (premium[row][c]) {
+    case 'd': lm = 2; break;
+    case 't': lm = 3; break;
+    case 'D': wm = 2; break;
+    case 'T': wm = 3; break;
+    }
+    sum += v * lm;
+    mult *= wm;
+    if (cross_sum[row][c] >= 0)
+      extra += (cross_sum[row][c] + v * lm) * wm;
+  }
+  /* A single tile that also makes a word across was found across: */
+  if (down && tiles == 1) {
+    for (c = start; !placed[c]; c++)
+      ;
+    if (cross_sum[row][c] >= 0)
+      return;
+  }
+
+  if (num_moves == max_moves) {
+    unsigned max = max_moves ? 2 * max_moves : 1024;
+    struct move *more = realloc(moves, max * sizeof(*more));
+    if (!more) {
+      out_of_memory = 1;
+      return;
+    }
+    moves = more;
+    max_moves = max;
+  }
+  struct move *mv = &moves[num_moves++];
+  mv->row = down ? start : row;
+  mv->col = down ? row : start;
+  mv->down = down;
+  mv->score = sum * mult + extra + (tiles == RACK_SIZE ? BINGO : 0);
+  memcpy(mv->word, line+start, end-start);
+  mv->word[end-start] = '\0';
+}
+
+/* Extend the word line[start..col), which led to trie node n, to the
+   right from col on.
+*/
+static void extend_right(unsigned n, unsigned start, unsigned col)
+{
+  if (col < SIZE && line[col]) {
+    /* A tile on the board must continue the word: */
+    if (walk(&n, line[col]))
+      extend_right(n, start, col+1);
+    return;
+  }
+  if (col > anchor && trie[n].end)
+    record(start, col);
+  if (col == SIZE)
+    return;
+
+  unsigned m;
+  placed[col] = 1;
+  for (m = trie[n].mask & cross[row][col]; m; m &= m-1) {
+    unsigned l = __builtin_ctz(m), k = trie_child(trie, n, l);
+    if (howmany[l]) {
+      howmany[l]--;
+      line[col] = 'A'+l;
+      extend_right(k, start, col+1);
+      howmany[l]++;
+    }
+    if (blanks) {
+      blanks--;
+      line[col] = 'a'+l;
+      extend_right(k, start, col+1);
+      blanks++;
+    }
+  }
+  line[col] = 0;
+  placed[col] = 0;
+}
+
+/* Build the part left of the anchor, len letters so far that led to trie
+   node n, on at most limit more empty squares.
+*/
+static void left_part(unsigned n, unsigned len, unsigned limit)
+{
+  unsigned i, m, start = anchor-len;
+
+  for (i = 0; i < len; i++) {
+    line[start+i] = left[i];
+    placed[start+i] = 1;
+  }
+  extend_right(n, start, anchor);
+  for (i = 0; i < len; i++) {
+    line[start+i] = 0;
+    placed[start+i] = 0;
+  }
+  if (!limit)
+    return;
+
+  for (m = trie[n].mask; m; m &= m-1) {
+    unsigned l = __builtin_ctz(m), k = trie_child(trie, n, l);
+    if (howmany[l]) {
+      howmany[l]--;
+      left[len] = 'A'+l;
+      left_part(k, len+1, limit-1);
+      howmany[l]++;
+    }
+    if (blanks) {
+      blanks--;
+      left[len] = 'a'+l;
+      left_part(k, len+1, limit-1);
+      blanks++;
+    }
+  }
+}
+
+/* Generate the moves across the rows of grid. */
+static void generate(unsigned rack_size)
+{
+  unsigned col;
+  cross_checks();
+  for (row = 0; row < SIZE; row++) {
+    unsigned limit = 0;
+    memcpy(line, grid[row], SIZE);
+    memset(placed, 0, SIZE);
+    for (col = 0; col < SIZE; col++) {
+      if (!is_anchor(row, col)) {
+	limit = grid[row][col] ? 0 : limit+1;
+	continue;
+      }
+      anchor = col;
+      if (col > 0 && grid[row][col-1]) {
+	/* The tiles left of the anchor start the word: */
+	unsigned start = col, i, n = 0;
+	int ok = 1;
+	while (start > 0 && grid[row][start-1])
+	  start--;
+	for (i = start; i < col && ok; i++)
+	  ok = walk(&n, grid[row][i]);
+	if (ok)
+	  extend_right(n, start, col);
+      }
+      else
+	/* The anchor itself takes a tile from the rack: */
+	left_part(0, 0, limit < rack_size ? limit : rack_size-1);
+      limit = 0;
+    }
+  }
+}
+
+static int move_cmp(const void *a, const void *b)
+{
+  const struct move *x = a, *y = b;
+  int d;
+  if (x->score != y->score)
+    return y->score - x->score;
+  if ((d = strcmp(x->word, y->word)))
+    return d;
+  if (x->row != y->row)
+    return x->row - y->row;
+  if (x->col != y->col)
+    return x->col - y->col;
+  return x->down - y->down;
+}
+
+/* Read the board from fp; returns 0 if malformed. */
+static int read_board(FILE *fp)
+{
+  char buf[256];
+  unsigned r, c;
+  empty_board = 1;
+  for (r = 0; r < SIZE; r++) {
+    if (!fgets(buf, sizeof(buf), fp))
+      return 0;
+    for (c = 0; c < SIZE && buf[c] && buf[c] != '\n'; c++)
+      if (isalpha(buf[c])) {
+	board[r][c] = buf[c];
+	empty_board = 0;
+      }
+  }
+  return 1;
+}
+
+int scrabble_main(int argc, char *argv[])
+{
+  unsigned rack_size = 0, r, c, i;
+  const char *p;
+  FILE *fp;
+
+  if (argc < 3) {
+    fprintf(stderr, "(E) Expect a board file and a rack\n");
+    return 3;
+  }
+  for (p = argv[2]; *p; p++, rack_size++) {
+    if (*p == '?')
+      blanks++;
+    else
+    if (isalpha(*p))
+      howmany[toupper(*p)-'A']++;
+    else {
+      fprintf(stderr, "(E) Expect only letters and ? on the rack: %s\n",
+	      argv[2]);
+      return 3;
+    }
+  }
+  if (!rack_size) {
+    fprintf(stderr, "(E) Expect a rack of at least 1 tile\n");
+    return 3;
+  }
+
+  fp = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin;
+  if (!fp) {
+    fprintf(stderr, "(E) Cannot open board file: %s\n", argv[1]);
+    return 3;
+  }
+  int ok = read_board(fp);
+  if (fp != stdin)
+    fclose(fp);
+  if (!ok) {
+    fprintf(stderr, "(E) Expect a board of %u lines of %u squares\n",
+	    SIZE, SIZE);
+    return 3;
+  }
+
+  if (!(trie = vocab_trie())) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  memcpy(grid, board, sizeof(grid));
+  generate(rack_size);
+  down = 1;
+  for (r = 0; r < SIZE; r++)
+    for (c = 0; c < SIZE; c++)
+      grid[r][c] = board[c][r];
+  generate(rack_size);
+  if (out_of_memory) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+
+  qsort(moves, num_moves, sizeof(*moves), move_cmp);
+  fprintf(stderr, "%u moves\n", num_moves);
+  for (i = 0; i < num_moves && (!max_results || i < max_results); i++) {
+    struct move *mv = &moves[i];
+    if (mv->down)
+      printf("%c%u %s %d\n", 'A'+mv->col, mv->row+1, mv->word, mv->score);
+    else
+      printf("%u%c %s %d\n", mv->row+1, 'A'+mv->col, mv->word, mv->score);
+  }
+  free(moves);
+  return 0;
+}
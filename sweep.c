@@ -0,0 +1,240 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Rack sweep: for every rack of a given size that can be drawn from a
+   distribution of tiles, the number of words of each length it makes.
+
+   The operand is the rack size, optionally followed by the tiles per
+   letter like 'E12Q0' that change the default English Scrabble
+   distribution (without blanks). The output on stdout is binary: per rack
+   in alphabetical order a record of its letters (size bytes, sorted) and
+   for each word length from 2 up to the size the number of words as 16
+   bits, least significant byte first; e.g. 19 bytes for a rack of 7.
+
+   The words a rack makes are those whose signature (their letters sorted,
+   see vocab.h) is a sub-multiset of the rack. The racks are enumerated
+   depth first with their letters in alphabetical order, which is also the
+   order of the signature trie: the signatures within a rack are those
+   within the rack less its last letter c, plus those extended with c.
+   Only the signatures that hold all of the rack's c's so far need to be
+   extended, so each is found exactly once and a rack costs no more than
+   the new signatures it brings. The top two letters of the racks divide
+   the work over the threads (-j).
+*/
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vocab.h"
+#include "words.h"
+
+/* Tiles per letter; default the English Scrabble distribution: */
+static unsigned tiles[26] = {
+  /*A*/ 9, /*B*/ 2, /*C*/ 2, /*D*/ 4, /*E*/12, /*F*/ 2, /*G*/ 3, /*H*/ 2,
+  /*I*/ 9, /*J*/ 1, /*K*/ 1, /*L*/ 4, /*M*/ 2, /*N*/ 6, /*O*/ 8, /*P*/ 2,
+  /*Q*/ 1, /*R*/ 6, /*S*/ 4, /*T*/ 6, /*U*/ 4, /*V*/ 2, /*W*/ 2, /*X*/ 1,
+  /*Y*/ 2, /*Z*/ 1
+};
+
+static const struct trie_node *trie;
+static unsigned size;
+static unsigned record_size;
+
+/* Work item: the racks that start with letters a and b, and their
+   records.
+*/
+struct task {
+  unsigned a, b;
+  unsigned char *out;
+  size_t out_len, out_max;
+  unsigned long racks;
+  int out_of_memory;
+};
+static struct task *tasks;
+static unsigned num_tasks;
+static unsigned next_task;
+
+/* Per thread: the rack so far and per level (number of letters) the
+   signatures within it as trie nodes, and the words per length.
+*/
+struct sweeper {
+  char rack[MAX_WORD_LEN];
+  unsigned used[26];
+  unsigned *nodes;			/* the signatures of all levels */
+  unsigned char *lens;			/* and their lengths */
+  unsigned end[MAX_WORD_LEN+1];		/* nodes of level d: [0,end[d]) */
+  unsigned added[MAX_WORD_LEN+1];	/* those new at level d: [added,end) */
+  unsigned words[MAX_WORD_LEN+1][MAX_WORD_LEN+1];
+  struct task *task;
+};
+
+/* Add letter c as letter d+1 of the rack. */
+static void extend(struct sweeper *sw, unsigned d, unsigned c)
+{
+  unsigned i, k = sw->end[d], len;
+  /* A repeated letter only extends the signatures that have all of its
+     earlier copies, i.e., those added with the previous copy:
+  */
+  unsigned from = d && sw->rack[d-1] == (char) c ? sw->added[d] : 0;
+
+  memcpy(sw->words[d+1], sw->words[d], sizeof(sw->words[d]));
+  sw->rack[d] = c;
+  sw->added[d+1] = k;
+  for (i = from; i < sw->end[d]; i++) {
+    unsigned n = sw->nodes[i];
+    if ((trie[n].mask >> c) & 1) {
+      unsigned m = trie_child(trie, n, c);
+      sw->nodes[k] = m;
+      len = sw->lens[k] = sw->lens[i]+1;
+      sw->words[d+1][len] += trie[m].end;
+      k++;
+    }
+  }
+  sw->end[d+1] = k;
+}
+
+static void record(struct sweeper *sw)
+{
+  struct task *t = sw->task;
+  unsigned i, len;
+  if (t->out_len + record_size > t->out_max) {
+    size_t max = t->out_max ? 2 * t->out_max : 1 << 12;
+    unsigned char *more = realloc(t->out, max);
+    if (!more) {
+      t->out_of_memory = 1;
+      return;
+    }
+    t->out = more;
+    t->out_max = max;
+  }
+  unsigned char *p = t->out + t->out_len;
+  for (i = 0; i < size; i++)
+    *p++ = 'A' + sw->rack[i];
+  for (len = MIN_WORD_LEN; len <= size; len++) {
+    unsigned n = sw->words[size][len];
+    if (n > 0xFFFF)
+      n = 0xFFFF;
+    *p++ = n & 0xFF;
+    *p++ = n >> 8;
+  }
+  t->out_len += record_size;
+  t->racks++;
+}
+
+/* Complete the rack of d letters with letters from c on. */
+static void sweep(struct sweeper *sw, unsigned d, unsigned c)
+{
+  if (d == size) {
+    record(sw);
+    return;
+  }
+  for (; c < 26; c++)
+    if (sw->used[c] < tiles[c]) {
+      sw->used[c]++;
+      extend(sw, d, c);
+      sweep(sw, d+1, c);
+      sw->used[c]--;
+    }
+}
+
+static void *sweep_worker(void *arg)
+{
+  struct sweeper sw;
+  unsigned i;
+  (void) arg;
+  memset(&sw, 0, sizeof(sw));
+  /* The levels share a stack of at most the sub-multisets of a rack: */
+  sw.nodes = malloc(sizeof(*sw.nodes) << size);
+  sw.lens = malloc((size_t) 1 << size);
+  if (!sw.nodes || !sw.lens) {
+    free(sw.nodes);
+    free(sw.lens);
+    return NULL;
+  }
+  sw.nodes[0] = 0;
+  sw.lens[0] = 0;
+  sw.end[0] = 1;
+  while ((i = __atomic_fetch_add(&next_task, 1, __ATOMIC_RELAXED))
+	 < num_tasks) {
+    struct task *t = &tasks[i];
+    sw.task = t;
+    sw.used[t->a]++;
+    extend(&sw, 0, t->a);
+    sw.used[t->b]++;
+    extend(&sw, 1, t->b);
+    sweep(&sw, 2, t->b);
+    sw.used[t->a]--;
+    sw.used[t->b]--;
+  }
+  free(sw.nodes);
+  free(sw.lens);
+  return NULL;
+}
+
+int sweep_main(int argc, char *argv[])
+{
+  unsigned a, b, i, t, nt = num_threads ? num_threads : 1;
+  unsigned long racks = 0;
+  int ok = 1;
+
+  size = atoi(argv[1]);
+  if (size < MIN_WORD_LEN || size > MAX_WORD_LEN) {
+    fprintf(stderr, "(E) Expect a rack size of %u to %u\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN);
+    return 3;
+  }
+  if (argc > 2) {
+    const char *spec = argv[2];
+    while (*spec) {
+      char *end;
+      if (!isalpha(*spec)) {
+	fprintf(stderr, "(E) Invalid tile distribution: %s\n", argv[2]);
+	return 3;
+      }
+      unsigned c = toupper(*spec++) - 'A';
+      tiles[c] = strtoul(spec, &end, 10);
+      if (end == spec) {
+	fprintf(stderr, "(E) Invalid tile distribution: %s\n", argv[2]);
+	return 3;
+      }
+      spec = end;
+    }
+  }
+  record_size = size + 2 * (size - MIN_WORD_LEN + 1);
+  if (!(trie = vocab_signature_trie())
+      || !(tasks = calloc(26 * 26, sizeof(*tasks)))) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (a = 0; a < 26; a++)
+    for (b = a; b < 26; b++)
+      if (tiles[a] && tiles[b] > (a == b)) {
+	tasks[num_tasks].a = a;
+	tasks[num_tasks++].b = b;
+      }
+
+  pthread_t *tid = malloc(nt * sizeof(*tid));
+  for (t = 1; tid && t < nt; t++)
+    if (pthread_create(&tid[t], NULL, sweep_worker, NULL))
+      break;
+  sweep_worker(NULL);
+  while (tid && --t > 0)
+    pthread_join(tid[t], NULL);
+  free(tid);
+
+  for (i = 0; i < num_tasks; i++) {
+    fwrite(tasks[i].out, 1, tasks[i].out_len, stdout);
+    racks += tasks[i].racks;
+    ok = ok && !tasks[i].out_of_memory;
+    free(tasks[i].out);
+  }
+  /* Every task is done, unless a thread could not get its memory: */
+  if (!ok || next_task < num_tasks) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  fprintf(stderr, "%lu racks\n", racks);
+  return 0;
+}
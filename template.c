@@ -0,0 +1,221 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Compile a word template to a DFA (see template.h for the syntax).
+
+   The template is first parsed into a sequence of elements, each a set of
+   letters (26-bit mask) that is optional and/or repeatable. A state of the
+   equivalent NFA is a position in that sequence; the DFA states are sets
+   of such positions (64-bit masks) found by the usual subset construction.
+*/
+
+#include <ctype.h>
+#include <string.h>
+
+#include "template.h"
+
+#define ALL_LETTERS ((1u << 26) - 1)
+#define MAX_ELEMS   63		       /* position MAX_ELEMS is `matched all' */
+#define MAX_LEN     31		       /* bits available in accept_in */
+
+typedef unsigned long long posset;
+
+static struct elem {
+  unsigned mask;		       /* letters allowed */
+  int optional;			       /* may be skipped */
+  int repeat;			       /* may be matched again */
+} elems[MAX_ELEMS];
+static unsigned num_elems;
+
+/* Add the positions reachable by skipping optional elements. */
+static posset closure(posset set)
+{
+  unsigned i;
+  for (i = 0; i < num_elems; i++)
+    if ((set >> i) & 1 && elems[i].optional)
+      set |= 1ULL << (i+1);
+  return set;
+}
+
+/* Parse a character class starting after the [; sets *mask. */
+static const char *parse_class(const char *p, unsigned *mask)
+{
+  int negate = 0;
+  unsigned set = 0;
+  if (*p == '^') {
+    negate = 1;
+    p++;
+  }
+  while (*p && *p != ']') {
+    if (!isalpha(*p))
+      return NULL;
+    unsigned from = toupper(*p++) - 'A', to = from;
+    if (*p == '-' && isalpha(p[1])) {
+      to = toupper(p[1]) - 'A';
+      p += 2;
+    }
+    for (; from <= to; from++)
+      set |= 1u << from;
+  }
+  if (*p != ']')
+    return NULL;
+  *mask = negate ? ALL_LETTERS & ~set : set;
+  return p+1;
+}
+
+/* Append an element; returns 0 if there are too many. */
+static int add_elem(unsigned mask, int optional, int repeat)
+{
+  if (num_elems == MAX_ELEMS)
+    return 0;
+  elems[num_elems].mask = mask;
+  elems[num_elems].optional = optional;
+  elems[num_elems].repeat = repeat;
+  num_elems++;
+  return 1;
+}
+
+const char *dfa_compile(struct dfa *dfa, const char *template)
+{
+  const char *p = template;
+  unsigned len = strlen(template);
+  int open_start = 0, open_end = 0;
+
+  num_elems = 0;
+  dfa->required = 0;
+
+  if (*p == '^')
+    p++;
+  if (len && template[len-1] == '$')
+    len--;
+  if (p > template || len < strlen(template)) {
+    /* An anchor on one side leaves the other side open: */
+    open_start = p == template;
+    open_end = len == strlen(template);
+  }
+  if (open_start)
+    add_elem(ALL_LETTERS, 1, 1);
+
+  while (p < template+len) {
+    unsigned mask;
+    int quantified = 0;
+    if (*p == '*' || *p == '+' || *p == '?') {
+      /* Quantifier on its own applies to a wildcard: */
+      mask = ALL_LETTERS;
+      quantified = 1;
+    }
+    else
+    if (*p == '[') {
+      p = parse_class(p+1, &mask);
+      if (!p || p > template+len)
+	return "Malformed character class";
+      if (!mask)
+	return "Empty character class";
+      /* A class may be followed by a quantifier: */
+      quantified = p < template+len;
+    }
+    else {
+      mask = isalpha(*p) ? 1u << (toupper(*p) - 'A') : ALL_LETTERS;
+      p++;
+    }
+
+    int ok;
+    switch (quantified ? *p : '\0') {
+    case '*':
+      ok = add_elem(mask, 1, 1);
+      p++;
+      break;
+    case '+':
+      ok = add_elem(mask, 0, 0) && add_elem(mask, 1, 1);
+      p++;
+      break;
+    case '?':
+      ok = add_elem(mask, 1, 0);
+      p++;
+      break;
+    default:
+      ok = add_elem(mask, 0, 0);
+      /* A single mandatory letter must be in any match: */
+      if (!(mask & (mask-1)))
+	dfa->required |= mask;
+      break;
+    }
+    if (!ok)
+      return "Template too long";
+  }
+  if (open_end)
+    if (!add_elem(ALL_LETTERS, 1, 1))
+      return "Template too long";
+
+  /* Fixed letters at the start and end: */
+  unsigned i, n;
+  for (n = 0; n < num_elems; n++)
+    if (elems[n].optional || elems[n].mask & (elems[n].mask-1))
+      break;
+  for (i = 0; i < n; i++)
+    dfa->prefix[i] = 'A' + __builtin_ctz(elems[i].mask);
+  dfa->prefix[n] = '\0';
+  for (n = 0; n < num_elems; n++) {
+    struct elem *e = &elems[num_elems-1-n];
+    if (e->optional || e->mask & (e->mask-1))
+      break;
+  }
+  for (i = 0; i < n; i++)
+    dfa->suffix[i] = 'A' + __builtin_ctz(elems[num_elems-n+i].mask);
+  dfa->suffix[n] = '\0';
+
+  /* Subset construction; states[] holds the position set of each state. */
+  static posset states[DFA_MAX_STATES];
+  unsigned s, c;
+
+  states[0] = closure(1);
+  dfa->num_states = 1;
+  for (s = 0; s < dfa->num_states; s++) {
+    dfa->allowed[s] = 0;
+    for (c = 0; c < 26; c++) {
+      posset to = 0;
+      for (i = 0; i < num_elems; i++)
+	if ((states[s] >> i) & 1 && (elems[i].mask >> c) & 1)
+	  to |= 1ULL << (elems[i].repeat ? i : i+1);
+      if (!to) {
+	dfa->next[s][c] = DFA_DEAD;
+	continue;
+      }
+      to = closure(to);
+      unsigned t;
+      for (t = 0; t < dfa->num_states; t++)
+	if (states[t] == to)
+	  break;
+      if (t == dfa->num_states) {
+	if (t == DFA_MAX_STATES)
+	  return "Template too complex";
+	states[dfa->num_states++] = to;
+      }
+      dfa->next[s][c] = t;
+      dfa->allowed[s] |= 1u << c;
+    }
+  }
+
+  /* Which lengths of completion each state can accept: */
+  for (s = 0; s < dfa->num_states; s++)
+    dfa->accept_in[s] = (states[s] >> num_elems) & 1;
+  unsigned k;
+  for (k = 1; k <= MAX_LEN; k++)
+    for (s = 0; s < dfa->num_states; s++)
+      for (c = 0; c < 26; c++) {
+	int t = dfa->next[s][c];
+	if (t != DFA_DEAD && (dfa->accept_in[t] >> (k-1)) & 1) {
+	  dfa->accept_in[s] |= 1u << k;
+	  break;
+	}
+      }
+  return NULL;
+}
+
+int dfa_match(const struct dfa *dfa, const char *word)
+{
+  int s = 0;
+  for (; *word; word++)
+    if ((s = dfa->next[s][*word-'A']) == DFA_DEAD)
+      return 0;
+  return dfa->accept_in[s] & 1;
+}
@@ -0,0 +1,44 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Word templates compiled to a deterministic finite automaton (DFA).
+
+   A template is matched against whole words. Its elements are:
+   - a letter (any case) that must occur at that position;
+   - a character class like [AEIOU] or [^XYZ], ranges as in [A-F] allowed;
+   - any other character, e.g. '.', as a wildcard for a single letter;
+   - * for any number of letters, + for at least one letter and ? for an
+     optional letter, so UN* are words starting with UN; directly after a
+     class these repeat or make optional that class, e.g. [AEIOU]+;
+   - an anchor ^ at the start and/or $ at the end. A template with an
+     anchor is open at the other end: ^UN means words starting with UN and
+     ING$ means words ending in ING. Without any anchor the template must
+     match the whole word (as if it were written ^...$).
+*/
+
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#define DFA_MAX_STATES 512
+#define DFA_DEAD       (-1)
+
+struct dfa {
+  unsigned num_states;		       /* state 0 is the start state */
+  short next[DFA_MAX_STATES][26];      /* successor state or DFA_DEAD */
+  unsigned allowed[DFA_MAX_STATES];    /* bit c: letter 'A'+c has successor */
+  /* Bit k set: exactly k more letters can lead to an accepting state. */
+  unsigned accept_in[DFA_MAX_STATES];
+  unsigned required;		       /* bit c: letter every match has */
+  char prefix[64];		       /* letters every match starts with */
+  char suffix[64];		       /* letters every match ends with */
+};
+
+/* Compile template into dfa. Returns NULL on success, else a message. */
+extern const char *dfa_compile(struct dfa *dfa, const char *template);
+
+/* Check whether the upper-case word is matched by the dfa. */
+extern int dfa_match(const struct dfa *dfa, const char *word);
+
+/* Check whether the dfa in state can still accept in exactly n letters. */
+#define dfa_can_accept(dfa, state, n) (((dfa)->accept_in[state] >> (n)) & 1)
+
+#endif /* TEMPLATE_H */
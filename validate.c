@@ -0,0 +1,344 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Validation: check a stream of words against the vocabulary in bulk.
+
+   The operands are files (- for stdin) of tokens separated by white
+   space. With -x the tokens that are words are written, with -u those
+   that are not, one per line and as given. Case does not matter; a token
+   with anything but letters is not a word.
+
+   Each word is packed into a 64-bit key of 5 bits per letter: the lower 5
+   bits of the ASCII code, 1 to 26 for either case. The keys are kept in a
+   hash table of buckets of 8 keys, a cache line each, so a lookup reads
+   one line (rarely more). The input is scanned 64 bytes at a time: SSE2
+   compares give a bitmask of the white space and one of the letters in
+   those bytes, and the tokens are found with bit scans on these masks;
+   their buckets are prefetched before they are looked up.
+   Files are mapped into memory and divided over the threads (-j), each
+   writing its share to a buffer; the buffers are output in order.
+*/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "vocab.h"
+#include "words.h"
+
+#define BUCKET 8			/* keys per bucket: 64 bytes */
+
+typedef unsigned long long wordkey;
+
+static wordkey *table;			/* 0: empty slot */
+static unsigned table_bits;
+
+static unsigned bucket_of(wordkey key)
+{
+  return (key * 0x9E3779B97F4A7C15ULL) >> (64 - table_bits);
+}
+
+/* Check whether key is in the table. */
+static int member(wordkey key)
+{
+  unsigned b = bucket_of(key), i;
+  for (;;) {
+    const wordkey *k = table + b * BUCKET;
+    for (i = 0; i < BUCKET; i++) {
+      if (k[i] == key)
+	return 1;
+      if (!k[i])
+	return 0;
+    }
+    /* Full bucket; go on with the next one: */
+    b = (b+1) & ((1u << table_bits) - 1);
+  }
+}
+
+static int build_table(void)
+{
+  unsigned len, n = 0, i;
+  for (len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++)
+    n += vocab_count(len);
+  /* About 4 keys per bucket at most, so a bucket is rarely full: */
+  for (table_bits = 1; (BUCKET/2u << table_bits) < n; table_bits++)
+    ;
+  size_t size = (size_t) BUCKET * sizeof(*table) << table_bits;
+  if (!(table = aligned_alloc(64, size)))
+    return 0;
+  memset(table, 0, size);
+  for (len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+    const char **wl = vocab_words(len);
+    for (i = 0; i < vocab_count(len); i++) {
+      wordkey key = 0, *k;
+      const char *p;
+      unsigned b, j;
+      for (p = wl[i]; *p; p++)
+	key = key << 5 | (*p & 31);
+      for (b = bucket_of(key);; b = (b+1) & ((1u << table_bits) - 1)) {
+	k = table + b * BUCKET;
+	for (j = 0; j < BUCKET && k[j]; j++)
+	  ;
+	if (j < BUCKET)
+	  break;
+      }
+      k[j] = key;
+    }
+  }
+  return 1;
+}
+
+/* Masks of the 64 bytes at p: bit i of *space set if p[i] is white space
+   (or a control character), of *alpha if it is a letter.
+*/
+static void classify(const unsigned char *p, unsigned long long *space,
+		     unsigned long long *alpha)
+{
+  unsigned long long s = 0, a = 0;
+#ifdef __SSE2__
+  unsigned i;
+  for (i = 0; i < 64; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *) (p+i));
+    /* Bytes <= ' ' as unsigned: */
+    __m128i ws = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(' ')),
+				_mm_set1_epi8(' '));
+    /* Letters: clearing bit 5 folds lower-case onto A-Z. */
+    __m128i t = _mm_sub_epi8(_mm_andnot_si128(_mm_set1_epi8(0x20), x),
+			     _mm_set1_epi8('A'));
+    __m128i az = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(25)), t);
+    s |= (unsigned long long) (unsigned) _mm_movemask_epi8(ws) << i;
+    a |= (unsigned long long) (unsigned) _mm_movemask_epi8(az) << i;
+  }
+#else
+  unsigned i;
+  for (i = 0; i < 64; i++) {
+    unsigned c = p[i];
+    s |= (unsigned long long) (c <= ' ') << i;
+    a |= (unsigned long long) ((c & ~0x20u) - 'A' < 26) << i;
+  }
+#endif
+  *space = s;
+  *alpha = a;
+}
+
+/* Output of one thread: */
+struct share {
+  const unsigned char *from, *to;
+  char *out;
+  size_t out_len, out_max;
+  unsigned long tokens, valid;
+  int out_of_memory;
+};
+static int want_valid;
+
+static void emit(struct share *sh, const unsigned char *token, unsigned len)
+{
+  if (sh->out_len + len + 1 > sh->out_max) {
+    size_t max = sh->out_max ? 2 * sh->out_max : 1 << 16;
+    while (max < sh->out_len + len + 1)
+      max *= 2;
+    char *more = realloc(sh->out, max);
+    if (!more) {
+      sh->out_of_memory = 1;
+      return;
+    }
+    sh->out = more;
+    sh->out_max = max;
+  }
+  memcpy(sh->out + sh->out_len, token, len);
+  sh->out_len += len;
+  sh->out[sh->out_len++] = '\n';
+}
+
+static void *validate_worker(void *arg)
+{
+  struct share *sh = arg;
+  const unsigned char *p = sh->from, *end = sh->to;
+  unsigned char pad[64];
+  /* At most 32 tokens in 64 bytes: */
+  struct { unsigned start, len; wordkey key; } tok[32];
+  unsigned num, i;
+
+  while (p < end) {
+    unsigned long long space, alpha, rest;
+    unsigned used = 64;
+    if (end - p < 64) {
+      /* Pad the tail with white space: */
+      memset(pad, ' ', 64);
+      memcpy(pad, p, end - p);
+      classify(pad, &space, &alpha);
+    }
+    else
+      classify(p, &space, &alpha);
+
+    /* First the tokens in these 64 bytes and the keys of the candidates,
+       prefetching their buckets; then the lookups, by which time most of
+       the buckets are in the cache. */
+    for (num = 0, rest = ~space; rest; ) {
+      unsigned s = __builtin_ctzll(rest), e, len;
+      unsigned long long after = space & (~0ULL << s);
+      if (!after) {
+	if (s) {
+	  /* The token goes on in the next 64 bytes: */
+	  used = s;
+	  break;
+	}
+	/* A token of 64 bytes or more is no word: */
+	for (e = 0; p+e < end && p[e] > ' '; e++)
+	  ;
+	tok[num].start = 0;
+	tok[num].len = e;
+	tok[num++].key = 0;
+	used = e;
+	break;
+      }
+      e = __builtin_ctzll(after);
+      len = e - s;
+      wordkey key = 0;
+      if (len >= MIN_WORD_LEN && len <= MAX_WORD_LEN
+	  && ((alpha >> s) & ((1ULL << len) - 1)) == (1ULL << len) - 1) {
+	unsigned i;
+	for (i = s; i < e; i++)
+	  key = key << 5 | (p[i] & 31);
+	__builtin_prefetch(table + bucket_of(key) * BUCKET);
+      }
+      tok[num].start = s;
+      tok[num].len = len;
+      tok[num++].key = key;
+      rest = ~space & (~0ULL << e);
+    }
+    for (i = 0; i < num; i++) {
+      int ok = tok[i].key && member(tok[i].key);
+      sh->valid += ok;
+      if (ok == want_valid)
+	emit(sh, p + tok[i].start, tok[i].len);
+    }
+    sh->tokens += num;
+    p += used;
+  }
+  return NULL;
+}
+
+/* Validate the n bytes of text; returns 0 if out of memory. */
+static int validate(const unsigned char *text, size_t n,
+		    unsigned long *tokens, unsigned long *valid)
+{
+  unsigned t, nt = num_threads ? num_threads : 1;
+  /* Small inputs are not worth the threads: */
+  if (n < (size_t) nt << 16)
+    nt = 1;
+  struct share *shares = calloc(nt, sizeof(*shares));
+  pthread_t *tid = malloc(nt * sizeof(*tid));
+  int ok = 1;
+  if (!shares || !tid) {
+    free(shares);
+    free(tid);
+    return 0;
+  }
+  /* Divide the text at white space: */
+  const unsigned char *from = text, *end = text + n;
+  for (t = 0; t < nt; t++) {
+    const unsigned char *to = t+1 == nt ? end : text + n / nt * (t+1);
+    if (to < from)
+      to = from;
+    while (to < end && *to > ' ')
+      to++;
+    shares[t].from = from;
+    shares[t].to = to;
+    from = to;
+  }
+  unsigned started;
+  for (t = 1; t < nt; t++)
+    if (pthread_create(&tid[t], NULL, validate_worker, &shares[t]))
+      break;
+  started = t;
+  /* This thread does the first share and those of threads not started: */
+  validate_worker(&shares[0]);
+  for (; t < nt; t++)
+    validate_worker(&shares[t]);
+  for (t = 1; t < started; t++)
+    pthread_join(tid[t], NULL);
+  for (t = 0; t < nt; t++) {
+    fwrite(shares[t].out, 1, shares[t].out_len, stdout);
+    *tokens += shares[t].tokens;
+    *valid += shares[t].valid;
+    ok = ok && !shares[t].out_of_memory;
+    free(shares[t].out);
+  }
+  free(shares);
+  free(tid);
+  return ok;
+}
+
+/* Read all of fp; returns NULL if out of memory. */
+static unsigned char *slurp(FILE *fp, size_t *n)
+{
+  size_t max = 1 << 16;
+  unsigned char *buf = malloc(max), *more;
+  *n = 0;
+  while (buf) {
+    *n += fread(buf + *n, 1, max - *n, fp);
+    if (*n < max)
+      break;
+    if (!(more = realloc(buf, max *= 2)))
+      free(buf);
+    buf = more;
+  }
+  return buf;
+}
+
+int validate_main(int argc, char *argv[])
+{
+  unsigned long tokens = 0, valid = 0;
+  int i;
+
+  want_valid = !validate_invalid;
+  if (!build_table()) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  for (i = 1; i < argc; i++) {
+    unsigned char *text;
+    size_t n;
+    int ok;
+    if (!strcmp(argv[i], "-")) {
+      if (!(text = slurp(stdin, &n))) {
+	fprintf(stderr, "(E) Out of memory\n");
+	return 6;
+      }
+      ok = validate(text, n, &tokens, &valid);
+      free(text);
+    }
+    else {
+      struct stat st;
+      int fd = open(argv[i], O_RDONLY);
+      if (fd < 0 || fstat(fd, &st) < 0) {
+	fprintf(stderr, "(E) Cannot open file: %s\n", argv[i]);
+	return 3;
+      }
+      n = st.st_size;
+      text = n ? mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+      close(fd);
+      if (n && text == MAP_FAILED) {
+	fprintf(stderr, "(E) Cannot map file: %s\n", argv[i]);
+	return 3;
+      }
+      ok = validate(text, n, &tokens, &valid);
+      if (n)
+	munmap(text, n);
+    }
+    if (!ok) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+  }
+  fprintf(stderr, "%lu tokens, %lu words\n", tokens, valid);
+  return 0;
+}
@@ -0,0 +1,932 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Vocabulary access and indexes; see vocab.h. */
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include "vocab.h"
+/* defines wordlist a vocabulary of MIN_WORD_LEN-MAX_WORD_LEN char words: */
+#include "wordlist.h"
+
+#define NUM_LENS (MAX_WORD_LEN-MIN_WORD_LEN+1)
+
+/* Drop the words that are not all letters, like CROSS-BUN: the indexes
+   have room for 26 letters only. The lists are rewritten in place on
+   first access, which must come before any threads are started.
+*/
+static void letters_only(void)
+{
+  static int done;
+  unsigned k, i, j;
+  if (done)
+    return;
+  for (k = 0; k < NUM_LENS; k++) {
+    const char **wl = wordlist[k];
+    for (i = j = 0; i < wordlist_len[k]; i++) {
+      const char *p = wl[i];
+      while (*p >= 'A' && *p <= 'Z')
+	p++;
+      if (!*p)
+	wl[j++] = wl[i];
+    }
+    wl[j] = 0;
+    wordlist_len[k] = j;
+  }
+  done = 1;
+}
+
+const char **vocab_words(unsigned len)
+{
+  letters_only();
+  return wordlist[len-MIN_WORD_LEN];
+}
+
+unsigned vocab_count(unsigned len)
+{
+  letters_only();
+  return wordlist_len[len-MIN_WORD_LEN];
+}
+
+int vocab_lookup(const char *word, unsigned len)
+{
+  /* Get the list of words of length len: */
+  const char **wl = vocab_words(len);
+#if 1
+  /* Since words are stored sorted, using binary search. */
+  int i = 0, j = vocab_count(len);
+
+  /* Binary search: */
+  while (i < j) {
+    int k = (i + j) >> 1 /* / 2 */;
+    int cmp = strcmp(word, wl[k]);
+    if (!cmp)
+      return 1;
+    if (cmp < 0)
+      j = k;
+    else
+      i = k + 1;
+  }
+#else
+  /* slower linear search */
+  unsigned i;
+  for (i = 0; wl[i]; i++)
+    if (!strcmp(wl[i], word))
+      return 1;
+#endif
+  return 0;
+}
+
+/* Compare the n letters before the ends pa and pb from right to left. */
+static int rev_ncmp(const char *pa, const char *pb, unsigned n)
+{
+  while (n--) {
+    int d = *--pa - *--pb;
+    if (d)
+      return d;
+  }
+  return 0;
+}
+
+/* Lower bound search in the sorted list wl of n words of length len:
+   the first index whose key (prefix or, if reversed, suffix) of k letters
+   is not less than the k letters of key.
+*/
+static unsigned lower_bound(const char **wl, unsigned n, unsigned len,
+			    const char *key, unsigned k, int reversed)
+{
+  unsigned i = 0, j = n;
+  while (i < j) {
+    unsigned m = (i + j) >> 1;
+    int cmp = reversed ? rev_ncmp(wl[m]+len, key+k, k)
+                       : strncmp(wl[m], key, k);
+    if (cmp < 0)
+      i = m + 1;
+    else
+      j = m;
+  }
+  return i;
+}
+
+/* Upper bound: the first index whose key is greater. */
+static unsigned upper_bound(const char **wl, unsigned n, unsigned len,
+			    const char *key, unsigned k, int reversed)
+{
+  unsigned i = 0, j = n;
+  while (i < j) {
+    unsigned m = (i + j) >> 1;
+    int cmp = reversed ? rev_ncmp(wl[m]+len, key+k, k)
+                       : strncmp(wl[m], key, k);
+    if (cmp <= 0)
+      i = m + 1;
+    else
+      j = m;
+  }
+  return i;
+}
+
+unsigned vocab_prefix_range(unsigned len, const char *prefix, unsigned n,
+			    unsigned *lo, unsigned *hi)
+{
+  const char **wl = vocab_words(len);
+  unsigned num = vocab_count(len);
+  *lo = lower_bound(wl, num, len, prefix, n, 0);
+  *hi = upper_bound(wl, num, len, prefix, n, 0);
+  return *hi - *lo;
+}
+
+/* Per length the words sorted on their reversal; built on demand. */
+static const char **reversed[NUM_LENS];
+static unsigned rev_len;	       /* word length for rev_cmp() */
+
+static int rev_cmp(const void *a, const void *b)
+{
+  return rev_ncmp(*(const char **) a + rev_len, *(const char **) b + rev_len,
+		  rev_len);
+}
+
+const char **vocab_reversed(unsigned len)
+{
+  const char ***rl = &reversed[len-MIN_WORD_LEN];
+  if (!*rl) {
+    unsigned n = vocab_count(len);
+    const char **wl = malloc(n * sizeof(*wl));
+    if (!wl)
+      return NULL;
+    memcpy(wl, vocab_words(len), n * sizeof(*wl));
+    rev_len = len;
+    qsort(wl, n, sizeof(*wl), rev_cmp);
+    *rl = wl;
+  }
+  return *rl;
+}
+
+unsigned vocab_suffix_range(unsigned len, const char *suffix, unsigned n,
+			    unsigned *lo, unsigned *hi)
+{
+  const char **rl = vocab_reversed(len);
+  unsigned num = vocab_count(len);
+  if (!rl) {
+    *lo = *hi = 0;
+    return 0;
+  }
+  *lo = lower_bound(rl, num, len, suffix, n, 1);
+  *hi = upper_bound(rl, num, len, suffix, n, 1);
+  return *hi - *lo;
+}
+
+unsigned vocab_bitwords(unsigned len)
+{
+  return (vocab_count(len) + BITWORD_BITS-1) / BITWORD_BITS;
+}
+
+/* Per length the bitsets for each position and letter; built on demand. */
+static bitword *posbits[NUM_LENS];
+
+const bitword *vocab_posbits(unsigned len, unsigned pos, unsigned c)
+{
+  bitword **pb = &posbits[len-MIN_WORD_LEN];
+  unsigned nb = vocab_bitwords(len);
+  if (!*pb) {
+    const char **wl = vocab_words(len);
+    unsigned i, n = vocab_count(len);
+    bitword *bits = calloc((size_t) len * 26 * nb, sizeof(*bits));
+    if (!bits)
+      return NULL;
+    for (i = 0; i < n; i++) {
+      unsigned p;
+      for (p = 0; p < len; p++)
+	bits[(p*26 + wl[i][p]-'A') * nb + i / BITWORD_BITS]
+	  |= 1ULL << (i % BITWORD_BITS);
+    }
+    *pb = bits;
+  }
+  return *pb + (pos*26 + c) * nb;
+}
+
+/* Per length the letter masks of each word; built on demand. */
+static struct letter_masks *masks[NUM_LENS];
+
+const struct letter_masks *vocab_masks(unsigned len)
+{
+  struct letter_masks **lm = &masks[len-MIN_WORD_LEN];
+  if (!*lm) {
+    const char **wl = vocab_words(len);
+    unsigned i, n = vocab_count(len);
+    struct letter_masks *m = malloc(n * sizeof(*m));
+    if (!m)
+      return NULL;
+    for (i = 0; i < n; i++) {
+      const char *p;
+      m[i].once = m[i].twice = m[i].thrice = 0;
+      for (p = wl[i]; *p; p++) {
+	unsigned bit = 1u << (*p-'A');
+	m[i].thrice |= m[i].twice & bit;
+	m[i].twice |= m[i].once & bit;
+	m[i].once |= bit;
+      }
+    }
+    *lm = m;
+  }
+  return *lm;
+}
+
+/* Per length the letter counts of each word; built on demand. */
+static struct letter_counts *counts[NUM_LENS];
+
+const struct letter_counts *vocab_counts(unsigned len)
+{
+  struct letter_counts **lc = &counts[len-MIN_WORD_LEN];
+  if (!*lc) {
+    const char **wl = vocab_words(len);
+    unsigned i, n = vocab_count(len);
+    struct letter_counts *m = aligned_alloc(sizeof(*m), (n+1) * sizeof(*m));
+    if (!m)
+      return NULL;
+    memset(m, 0, (n+1) * sizeof(*m));
+    for (i = 0; i < n; i++) {
+      const char *p;
+      for (p = wl[i]; *p; p++)
+	m[i].n[*p-'A']++;
+    }
+    *lc = m;
+  }
+  return *lc;
+}
+
+/* Per length the letter counts of each word in nibbles; built on demand. */
+static struct letter_nibbles *nibbles[NUM_LENS];
+
+void vocab_pack_nibbles(const unsigned count[26], struct letter_nibbles *ln)
+{
+  unsigned c;
+  ln->lo = ln->hi = 0;
+  for (c = 0; c < 26; c++) {
+    unsigned long long k = count[c] < 15 ? count[c] : 15;
+    if (c < 16)
+      ln->lo |= k << (4*c);
+    else
+      ln->hi |= k << (4*(c-16));
+  }
+}
+
+const struct letter_nibbles *vocab_nibbles(unsigned len)
+{
+  struct letter_nibbles **ln = &nibbles[len-MIN_WORD_LEN];
+  if (!*ln) {
+    const char **wl = vocab_words(len);
+    unsigned i, n = vocab_count(len);
+    struct letter_nibbles *m = malloc((n+1) * sizeof(*m));
+    if (!m)
+      return NULL;
+    for (i = 0; i < n; i++) {
+      unsigned count[26] = { 0 };
+      const char *p;
+      for (p = wl[i]; *p; p++)
+	count[*p-'A']++;
+      vocab_pack_nibbles(count, &m[i]);
+    }
+    *ln = m;
+  }
+  return *ln;
+}
+
+/* Per length the bitsets of words with some letter; built on demand. */
+static bitword *letterbits[NUM_LENS];
+
+const bitword *vocab_letterbits(unsigned len, unsigned c)
+{
+  bitword **lb = &letterbits[len-MIN_WORD_LEN];
+  unsigned nb = vocab_bitwords(len);
+  if (!*lb) {
+    bitword *bits = calloc((size_t) 26 * nb, sizeof(*bits));
+    unsigned pos, l, i;
+    if (!bits || !vocab_posbits(len, 0, 0)) {
+      free(bits);
+      return NULL;
+    }
+    for (l = 0; l < 26; l++)
+      for (pos = 0; pos < len; pos++) {
+	const bitword *pb = vocab_posbits(len, pos, l);
+	for (i = 0; i < nb; i++)
+	  bits[l * nb + i] |= pb[i];
+      }
+    *lb = bits;
+  }
+  return *lb + c * nb;
+}
+
+isokey vocab_isomorph_key(const char *word, unsigned len)
+{
+  unsigned i, j, distinct = 0;
+  unsigned char num[MAX_WORD_LEN];
+  isokey key = 0;
+  for (i = 0; i < len; i++) {
+    for (j = 0; j < i && word[j] != word[i]; j++)
+      ;
+    num[i] = j < i ? num[j] : distinct++;
+    key |= (isokey) num[i] << (4*i);
+  }
+  return key;
+}
+
+/* Per length the words grouped on their isomorph key and a hash table
+   from key to group; built on demand.
+*/
+struct iso_entry {
+  isokey key;
+  unsigned start, count;		/* count 0: entry not used */
+};
+static struct iso_index {
+  unsigned *order;			/* word indices grouped on key */
+  struct iso_entry *table;
+  unsigned bits;			/* table has 1 << bits entries */
+} isomorphs[NUM_LENS];
+
+static unsigned iso_hash(isokey key, unsigned bits)
+{
+  return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+static const isokey *iso_keys;		/* for iso_cmp() */
+
+static int iso_cmp(const void *a, const void *b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  if (iso_keys[x] != iso_keys[y])
+    return iso_keys[x] < iso_keys[y] ? -1 : 1;
+  return x < y ? -1 : x > y;
+}
+
+const unsigned *vocab_isomorphs(unsigned len, isokey key, unsigned *n)
+{
+  struct iso_index *ix = &isomorphs[len-MIN_WORD_LEN];
+  unsigned i, h, mask;
+  if (!ix->order) {
+    const char **wl = vocab_words(len);
+    unsigned count = vocab_count(len), bits = 1;
+    isokey *keys = malloc(count * sizeof(*keys));
+    unsigned *order = malloc(count * sizeof(*order));
+    /* At least twice as many entries as words, so at most half full: */
+    while ((1u << bits) < 2 * count)
+      bits++;
+    struct iso_entry *table = calloc(1u << bits, sizeof(*table));
+    if (!keys || !order || !table) {
+      free(keys);
+      free(order);
+      free(table);
+      return NULL;
+    }
+    for (i = 0; i < count; i++) {
+      keys[i] = vocab_isomorph_key(wl[i], len);
+      order[i] = i;
+    }
+    iso_keys = keys;
+    qsort(order, count, sizeof(*order), iso_cmp);
+    mask = (1u << bits) - 1;
+    for (i = 0; i < count; i++) {
+      isokey k = keys[order[i]];
+      unsigned j;
+      if (i && k == keys[order[i-1]])
+	continue;
+      for (h = iso_hash(k, bits); table[h].count; h = (h+1) & mask)
+	;
+      for (j = i; j < count && keys[order[j]] == k; j++)
+	;
+      table[h].key = k;
+      table[h].start = i;
+      table[h].count = j-i;
+    }
+    free(keys);
+    ix->order = order;
+    ix->table = table;
+    ix->bits = bits;
+  }
+  mask = (1u << ix->bits) - 1;
+  for (h = iso_hash(key, ix->bits); ix->table[h].count; h = (h+1) & mask)
+    if (ix->table[h].key == key) {
+      *n = ix->table[h].count;
+      return ix->order + ix->table[h].start;
+    }
+  *n = 0;
+  return ix->order;
+}
+
+/* Per length the wildcard buckets: for each word and position the word
+   with that position blanked, packed 5 bits per character into a key,
+   sorted on key so the words of a bucket are adjacent; built on demand.
+*/
+struct wildcard {
+  unsigned long long key;
+  unsigned word;
+};
+static struct wildcard *wildcards[NUM_LENS];
+
+/* Character code: 0 for the blank, 1-26 for the letters. */
+static unsigned long long wild_key(const char *word, unsigned len,
+				   unsigned blank)
+{
+  unsigned long long key = 0;
+  unsigned i;
+  for (i = 0; i < len; i++) {
+    unsigned c = i == blank ? 0 : word[i]-'A'+1;
+    key = key << 5 | c;
+  }
+  return key;
+}
+
+static int wild_cmp(const void *a, const void *b)
+{
+  const struct wildcard *x = a, *y = b;
+  if (x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return x->word < y->word ? -1 : x->word > y->word;
+}
+
+int vocab_neighbours(unsigned len, unsigned w, unsigned *out)
+{
+  struct wildcard **wc = &wildcards[len-MIN_WORD_LEN];
+  const char **wl = vocab_words(len);
+  unsigned n = vocab_count(len) * len, pos, num = 0;
+  if (!*wc) {
+    struct wildcard *e = malloc(n * sizeof(*e));
+    unsigned i;
+    if (!e)
+      return -1;
+    for (i = 0; i < n; i++) {
+      e[i].word = i / len;
+      e[i].key = wild_key(wl[i / len], len, i % len);
+    }
+    qsort(e, n, sizeof(*e), wild_cmp);
+    *wc = e;
+  }
+  for (pos = 0; pos < len; pos++) {
+    unsigned long long key = wild_key(wl[w], len, pos);
+    unsigned lo = 0, hi = n;
+    /* Lower bound of the bucket: */
+    while (lo < hi) {
+      unsigned mid = (lo + hi) / 2;
+      if ((*wc)[mid].key < key)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+    for (; lo < n && (*wc)[lo].key == key; lo++)
+      if ((*wc)[lo].word != w)
+	out[num++] = (*wc)[lo].word;
+  }
+  return num;
+}
+
+sigkey vocab_signature(const char *word, unsigned len)
+{
+  unsigned count[26] = { 0 }, i, c;
+  sigkey sig = 0;
+  for (i = 0; i < len; i++)
+    count[word[i]-'A']++;
+  for (c = 0; c < 26; c++)
+    for (i = 0; i < count[c]; i++)
+      sig = sig << 5 | (c+1);
+  return sig;
+}
+
+/* Per length the word indices sorted on signature, and the signatures in
+   the same order; built on demand.
+*/
+static struct sig_index {
+  sigkey *keys;
+  unsigned *order;
+} signatures[NUM_LENS];
+
+static const sigkey *sig_keys;		/* for sig_cmp() */
+
+static int sig_cmp(const void *a, const void *b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  if (sig_keys[x] != sig_keys[y])
+    return sig_keys[x] < sig_keys[y] ? -1 : 1;
+  return x < y ? -1 : x > y;
+}
+
+const unsigned *vocab_anagrams(unsigned len, sigkey sig, unsigned *n)
+{
+  struct sig_index *ix = &signatures[len-MIN_WORD_LEN];
+  unsigned count = vocab_count(len), lo = 0, hi = count, i;
+  if (!ix->order) {
+    const char **wl = vocab_words(len);
+    sigkey *keys = malloc(count * sizeof(*keys));
+    sigkey *sorted = malloc(count * sizeof(*sorted));
+    unsigned *order = malloc(count * sizeof(*order));
+    if (!keys || !sorted || !order) {
+      free(keys);
+      free(sorted);
+      free(order);
+      return NULL;
+    }
+    for (i = 0; i < count; i++) {
+      keys[i] = vocab_signature(wl[i], len);
+      order[i] = i;
+    }
+    sig_keys = keys;
+    qsort(order, count, sizeof(*order), sig_cmp);
+    for (i = 0; i < count; i++)
+      sorted[i] = keys[order[i]];
+    free(keys);
+    ix->keys = sorted;
+    ix->order = order;
+  }
+  /* Lower bound of the anagrams: */
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (ix->keys[mid] < sig)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (hi = lo; hi < count && ix->keys[hi] == sig; hi++)
+    ;
+  *n = hi - lo;
+  return ix->order + lo;
+}
+
+/* The trie of all words; built on demand. */
+static struct trie_node *trie;
+
+/* The trie being filled in by trie_build() and its number of nodes: */
+static struct trie_node *building;
+static unsigned building_num;
+
+static int str_cmp(const void *a, const void *b)
+{
+  return strcmp(*(const char **) a, *(const char **) b);
+}
+
+/* Fill in node for the n sorted words wl that share their first depth
+   letters; its children are allocated as one block.
+*/
+static void trie_build(unsigned node, const char **wl, unsigned n,
+		       unsigned depth)
+{
+  struct trie_node *t = &building[node];
+  unsigned i, j, k;
+  t->mask = 0;
+  /* The words that end here come first: */
+  for (t->end = 0; t->end < n && !wl[t->end][depth]; t->end++)
+    ;
+  wl += t->end;
+  n -= t->end;
+  for (i = 0; i < n; i++)
+    t->mask |= 1u << (wl[i][depth]-'A');
+  t->first = building_num;
+  building_num += __builtin_popcount(t->mask);
+  for (i = 0, k = t->first; i < n; i = j, k++) {
+    for (j = i+1; j < n && wl[j][depth] == wl[i][depth]; j++)
+      ;
+    trie_build(k, wl+i, j-i, depth+1);
+  }
+}
+
+const struct trie_node *vocab_trie(void)
+{
+  if (!trie) {
+    unsigned len, n = 0, letters = 0;
+    for (len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+      n += vocab_count(len);
+      letters += len * vocab_count(len);
+    }
+    /* At most a node per letter plus the root: */
+    const char **all = malloc(n * sizeof(*all));
+    trie = malloc((letters+1) * sizeof(*trie));
+    if (!all || !trie) {
+      free(all);
+      free(trie);
+      trie = NULL;
+      return NULL;
+    }
+    for (n = 0, len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+      memcpy(all+n, vocab_words(len), vocab_count(len) * sizeof(*all));
+      n += vocab_count(len);
+    }
+    qsort(all, n, sizeof(*all), str_cmp);
+    building = trie;
+    building_num = 1;
+    trie_build(0, all, n, 0);
+    free(all);
+  }
+  return trie;
+}
+
+/* The trie of the signatures; built on demand. */
+static struct trie_node *sig_trie;
+
+const struct trie_node *vocab_signature_trie(void)
+{
+  if (!sig_trie) {
+    unsigned len, n = 0, letters = 0, i;
+    for (len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+      n += vocab_count(len);
+      letters += len * vocab_count(len);
+    }
+    /* The signatures as strings of sorted letters: */
+    const char **all = malloc(n * sizeof(*all));
+    char *text = malloc(letters + n);
+    sig_trie = malloc((letters+1) * sizeof(*sig_trie));
+    if (!all || !text || !sig_trie) {
+      free(all);
+      free(text);
+      free(sig_trie);
+      sig_trie = NULL;
+      return NULL;
+    }
+    char *p = text;
+    for (n = 0, len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+      const char **wl = vocab_words(len);
+      for (i = 0; i < vocab_count(len); i++) {
+	sigkey sig = vocab_signature(wl[i], len);
+	unsigned j;
+	all[n++] = p;
+	for (j = len; j-- > 0; sig >>= 5)
+	  p[j] = 'A' + (sig & 31) - 1;
+	p[len] = '\0';
+	p += len+1;
+      }
+    }
+    qsort(all, n, sizeof(*all), str_cmp);
+    building = sig_trie;
+    building_num = 1;
+    trie_build(0, all, n, 0);
+    free(all);
+    free(text);
+  }
+  return sig_trie;
+}
+
+/* State of vocab_subsignatures(): */
+struct sub_walk {
+  unsigned count[26];			/* letters of the rack left */
+  unsigned min_len, max_len, max_words;
+  unsigned words;
+  sigkey *sigs;
+  unsigned char *lens;
+  unsigned num;
+};
+
+/* Visit the children of node n for the letters from c on; returns 0 as
+   soon as there are too many words.
+*/
+static int sub_walk(struct sub_walk *w, unsigned n, unsigned c, sigkey sig,
+		    unsigned len)
+{
+  for (; c < 26; c++)
+    if (w->count[c] && ((sig_trie[n].mask >> c) & 1)) {
+      unsigned m = trie_child(sig_trie, n, c);
+      sigkey s = sig << 5 | (c+1);
+      if (sig_trie[m].end && len+1 >= w->min_len && len+1 <= w->max_len) {
+	if ((w->words += sig_trie[m].end) > w->max_words)
+	  return 0;
+	w->sigs[w->num] = s;
+	w->lens[w->num++] = len+1;
+      }
+      if (len+1 < w->max_len) {
+	w->count[c]--;
+	if (!sub_walk(w, m, c, s, len+1))
+	  return 0;
+	w->count[c]++;
+      }
+    }
+  return 1;
+}
+
+int vocab_subsignatures(const unsigned count[26], unsigned min_len,
+			unsigned max_len, unsigned max_words, sigkey *sigs,
+			unsigned char *lens, unsigned *words)
+{
+  struct sub_walk w;
+  memcpy(w.count, count, sizeof(w.count));
+  w.min_len = min_len;
+  w.max_len = max_len;
+  w.max_words = max_words;
+  w.words = 0;
+  w.sigs = sigs;
+  w.lens = lens;
+  w.num = 0;
+  if (!sub_walk(&w, 0, 0, 0, 0))
+    return -1;
+  *words = w.words;
+  return w.num;
+}
+
+static unsigned bits_and_count_scalar(const bitword *a, const bitword *b,
+				      unsigned nb)
+{
+  unsigned i, n = 0;
+  for (i = 0; i < nb; i++)
+    n += __builtin_popcountll(a[i] & b[i]);
+  return n;
+}
+
+#ifdef __x86_64__
+/* AVX2 population count: per nibble a table lookup with vpshufb, the
+   byte counts summed with vpsadbw.
+*/
+__attribute__((target("avx2")))
+static unsigned bits_and_count_avx2(const bitword *a, const bitword *b,
+				    unsigned nb)
+{
+  const __m256i table = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+					 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  __m256i sum = _mm256_setzero_si256();
+  unsigned i;
+
+  for (i = 0; i + 4 <= nb; i += 4) {
+    __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(a+i)),
+				 _mm256_loadu_si256((const __m256i *)(b+i)));
+    __m256i cnt = _mm256_add_epi8(
+      _mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+      _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4),
+						  low)));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(cnt,
+						_mm256_setzero_si256()));
+  }
+  unsigned n = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1)
+	     + _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+  return n + bits_and_count_scalar(a+i, b+i, nb-i);
+}
+#endif
+
+unsigned bits_and_count(const bitword *a, const bitword *b, unsigned nb)
+{
+#ifdef __x86_64__
+  static int has_avx2 = -1;
+  if (has_avx2 < 0)
+    has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_avx2)
+    return bits_and_count_avx2(a, b, nb);
+#endif
+  return bits_and_count_scalar(a, b, nb);
+}
+
+/* The rack kernels store the index of every word of wc[0..n) that has at
+   most blanks letters more than rack. A word's excess per letter is a
+   saturating subtraction of the rack's count from its own; the index is
+   stored unconditionally and kept by counting it, so there is no branch
+   per word.
+*/
+
+/* SWAR on the 4-bit counts, for processors without SSE2 (and on x86-64
+   if built with -DRACK_SCAN_SWAR=1): the even and the odd nibbles of each
+   half are spread over bytes, leaving bit 4 of each byte as a guard.
+   (r | 0x10) - w then cannot borrow from the next byte, and keeps bit 4
+   set just where r >= w. Likewise (w | 0x10) - r keeps bit 4 set where
+   w >= r, with w - r in the low nibble.
+*/
+#define NIBBLES 0x0F0F0F0F0F0F0F0FULL
+#define GUARDS  0x1010101010101010ULL
+
+/* Excess of the counts w over r in the bytes of a quarter of a word:
+   per byte at most 15.
+*/
+static unsigned long long swar_excess(unsigned long long w,
+				      unsigned long long r)
+{
+  unsigned long long d = (w | GUARDS) - r, ge = d & GUARDS;
+  /* 0x0F in the bytes where w >= r: */
+  return d & (ge - (ge >> 4));
+}
+
+static unsigned rack_scan_swar(const struct letter_nibbles *wn, unsigned n,
+			       const struct letter_nibbles *rack,
+			       unsigned blanks, unsigned *out)
+{
+  const unsigned long long r0 = rack->lo & NIBBLES;
+  const unsigned long long r1 = rack->lo >> 4 & NIBBLES;
+  const unsigned long long r2 = rack->hi & NIBBLES;
+  const unsigned long long r3 = rack->hi >> 4 & NIBBLES;
+  unsigned i, num = 0;
+
+  if (!blanks) {
+    for (i = 0; i < n; i++) {
+      unsigned long long w0 = wn[i].lo & NIBBLES, w1 = wn[i].lo >> 4 & NIBBLES;
+      unsigned long long w2 = wn[i].hi & NIBBLES, w3 = wn[i].hi >> 4 & NIBBLES;
+      unsigned long long fits = ((r0 | GUARDS) - w0) & ((r1 | GUARDS) - w1)
+			      & ((r2 | GUARDS) - w2) & ((r3 | GUARDS) - w3);
+      out[num] = i;
+      num += (fits & GUARDS) == GUARDS;
+    }
+    return num;
+  }
+  for (i = 0; i < n; i++) {
+    unsigned long long x
+      = swar_excess(wn[i].lo & NIBBLES, r0)
+      + swar_excess(wn[i].lo >> 4 & NIBBLES, r1)
+      + swar_excess(wn[i].hi & NIBBLES, r2)
+      + swar_excess(wn[i].hi >> 4 & NIBBLES, r3);
+    /* Bytes of at most 60 to 16-bit fields, summed in the top one: */
+    x = (x & 0x00FF00FF00FF00FFULL) + (x >> 8 & 0x00FF00FF00FF00FFULL);
+    out[num] = i;
+    num += (x * 0x0001000100010001ULL) >> 48 <= blanks;
+  }
+  return num;
+}
+
+#ifdef __x86_64__
+/* SSE2, part of every x86-64: the 32 counts in two halves. */
+static unsigned rack_scan_sse2(const struct letter_counts *wc, unsigned n,
+			       const struct letter_counts *rack,
+			       unsigned blanks, unsigned *out)
+{
+  const __m128i r0 = _mm_load_si128((const __m128i *) rack->n);
+  const __m128i r1 = _mm_load_si128((const __m128i *) (rack->n+16));
+  const __m128i zero = _mm_setzero_si128();
+  unsigned i, num = 0;
+
+  for (i = 0; i < n; i++) {
+    __m128i d0 = _mm_subs_epu8(_mm_load_si128((const __m128i *) wc[i].n), r0);
+    __m128i d1 = _mm_subs_epu8(_mm_load_si128((const __m128i *)
+					      (wc[i].n+16)), r1);
+    out[num] = i;
+    if (!blanks)
+      num += _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(d0, d1), zero))
+	     == 0xFFFF;
+    else {
+      /* Sum the excess with vpsadbw: */
+      __m128i s = _mm_add_epi64(_mm_sad_epu8(d0, zero),
+				_mm_sad_epu8(d1, zero));
+      s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+      num += (unsigned) _mm_cvtsi128_si32(s) <= blanks;
+    }
+  }
+  return num;
+}
+
+/* AVX2: one word of 32 counts per register. */
+__attribute__((target("avx2")))
+static unsigned rack_scan_avx2(const struct letter_counts *wc, unsigned n,
+			       const struct letter_counts *rack,
+			       unsigned blanks, unsigned *out)
+{
+  const __m256i r = _mm256_load_si256((const __m256i *) rack->n);
+  const __m256i zero = _mm256_setzero_si256();
+  unsigned i, num = 0;
+
+  if (!blanks) {
+    for (i = 0; i < n; i++) {
+      __m256i d = _mm256_subs_epu8(_mm256_load_si256((const __m256i *)
+						     wc[i].n), r);
+      out[num] = i;
+      num += _mm256_testz_si256(d, d);
+    }
+    return num;
+  }
+  for (i = 0; i < n; i++) {
+    __m256i d = _mm256_subs_epu8(_mm256_load_si256((const __m256i *)
+						   wc[i].n), r);
+    __m256i s = _mm256_sad_epu8(d, zero);
+    __m128i t = _mm_add_epi64(_mm256_castsi256_si128(s),
+			      _mm256_extracti128_si256(s, 1));
+    t = _mm_add_epi64(t, _mm_unpackhi_epi64(t, t));
+    out[num] = i;
+    num += (unsigned) _mm_cvtsi128_si32(t) <= blanks;
+  }
+  return num;
+}
+#endif
+
+/* Build with -DRACK_SCAN_SWAR=1 to use the SWAR kernel on x86-64 too,
+   e.g. to compare it with the others.
+*/
+#ifndef RACK_SCAN_SWAR
+#define RACK_SCAN_SWAR 0
+#endif
+
+unsigned vocab_rack_scan(unsigned len, const struct letter_counts *rack,
+			 unsigned blanks, unsigned *out)
+{
+  unsigned n = vocab_count(len);
+#ifdef __x86_64__
+  if (!RACK_SCAN_SWAR) {
+    static int has_avx2 = -1;
+    const struct letter_counts *wc = vocab_counts(len);
+    if (!wc)
+      return -1;
+    if (has_avx2 < 0)
+      has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+      return rack_scan_avx2(wc, n, rack, blanks, out);
+    return rack_scan_sse2(wc, n, rack, blanks, out);
+  }
+#endif
+  const struct letter_nibbles *wn = vocab_nibbles(len);
+  struct letter_nibbles rn;
+  unsigned count[26], c;
+  if (!wn)
+    return -1;
+  for (c = 0; c < 26; c++)
+    count[c] = rack->n[c];
+  vocab_pack_nibbles(count, &rn);
+  return rack_scan_swar(wn, n, &rn, blanks, out);
+}
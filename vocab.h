@@ -0,0 +1,184 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Access to the vocabulary of wordlist.h and indexes built on top of it.
+
+   Words are upper-case and kept in separate lists per length, each sorted
+   alphabetically. Indexes are built on first use.
+*/
+
+#ifndef VOCAB_H
+#define VOCAB_H
+
+#define MIN_WORD_LEN 2
+#define MAX_WORD_LEN 12
+
+/* Bitsets over the words of one length: bit i stands for word i. */
+typedef unsigned long long bitword;
+#define BITWORD_BITS 64
+
+/* The sorted list of words of length len and how many there are. */
+extern const char **vocab_words(unsigned len);
+extern unsigned vocab_count(unsigned len);
+
+/* Check whether word of length len is in the vocabulary. */
+extern int vocab_lookup(const char *word, unsigned len);
+
+/* Find the range [*lo,*hi) of words of length len that start with the n
+   letters of prefix. Returns the number of such words.
+*/
+extern unsigned vocab_prefix_range(unsigned len, const char *prefix,
+				   unsigned n, unsigned *lo, unsigned *hi);
+
+/* The words of length len sorted on their reversal, i.e., as if spelled
+   backwards, such that words with the same suffix are adjacent. NULL if
+   out of memory.
+*/
+extern const char **vocab_reversed(unsigned len);
+
+/* Find the range [*lo,*hi) in vocab_reversed(len) of the words that end
+   in the n letters of suffix. Returns the number of such words; the range
+   is empty if vocab_reversed(len) is out of memory.
+*/
+extern unsigned vocab_suffix_range(unsigned len, const char *suffix,
+				   unsigned n, unsigned *lo, unsigned *hi);
+
+/* Number of bitwords in a bitset over the words of length len. */
+extern unsigned vocab_bitwords(unsigned len);
+
+/* Positional index: the bitset of words of length len that have letter
+   c (0-25) at position pos. Returns NULL if out of memory.
+*/
+extern const bitword *vocab_posbits(unsigned len, unsigned pos, unsigned c);
+
+/* Letter masks of a word: bit c (0-25) set if letter c occurs at least
+   once, twice or three times.
+*/
+struct letter_masks {
+  unsigned once, twice, thrice;
+};
+
+/* The letter masks of each of the words of length len; NULL if out of
+   memory.
+*/
+extern const struct letter_masks *vocab_masks(unsigned len);
+
+/* Letter counts of a word: per letter c (0-25) the number of times it
+   occurs, padded with zeros to 32 bytes for vector compares.
+*/
+struct letter_counts {
+  unsigned char n[32];
+} __attribute__((aligned(32)));
+
+/* The letter counts of each of the words of length len; NULL if out of
+   memory.
+*/
+extern const struct letter_counts *vocab_counts(unsigned len);
+
+/* Letter counts of a word in 4 bits per letter, at most 15: letters 0-15
+   in lo, 16-25 in hi, the first in the lowest bits.
+*/
+struct letter_nibbles {
+  unsigned long long lo, hi;
+};
+
+/* Pack the 26 letter counts into ln. */
+extern void vocab_pack_nibbles(const unsigned count[26],
+			       struct letter_nibbles *ln);
+
+/* The letter nibbles of each of the words of length len; NULL if out of
+   memory.
+*/
+extern const struct letter_nibbles *vocab_nibbles(unsigned len);
+
+/* Store in out the indices of the words of length len that can be made
+   from the letters counted in rack plus at most blanks other letters, in
+   alphabetical order; out needs room for vocab_count(len). Returns their
+   number, or (unsigned) -1 if out of memory. Uses AVX2 if the processor
+   has it, else SSE2 on x86-64 or else SWAR on the letter nibbles; the
+   latter also on x86-64 if built with -DRACK_SCAN_SWAR=1.
+*/
+extern unsigned vocab_rack_scan(unsigned len,
+				const struct letter_counts *rack,
+				unsigned blanks, unsigned *out);
+
+/* The bitset of words of length len that have letter c anywhere. */
+extern const bitword *vocab_letterbits(unsigned len, unsigned c);
+
+/* Isomorph key of a word of length len: per position 4 bits with the
+   number of distinct letters seen before the first occurrence of its
+   letter, so ABCA, THAT and 1231 all have the key of 0120. Any characters
+   may be used; they are compared for equality only.
+*/
+typedef unsigned long long isokey;
+extern isokey vocab_isomorph_key(const char *word, unsigned len);
+
+/* The indices of the words of length len with isomorph key, in
+   alphabetical order; *n is set to their number. Returns NULL if out of
+   memory.
+*/
+extern const unsigned *vocab_isomorphs(unsigned len, isokey key,
+				       unsigned *n);
+
+/* Word-ladder neighbours of word number w of length len: the words that
+   differ from it in exactly one position. Their indices are stored in out,
+   which must have room for MAX_NEIGHBOURS. Returns their number or -1 if
+   out of memory.
+*/
+#define MAX_NEIGHBOURS (MAX_WORD_LEN * 25)
+extern int vocab_neighbours(unsigned len, unsigned w, unsigned *out);
+
+/* Signature of a word of length len: its letters in alphabetical order,
+   packed 5 bits per letter (1-26) with the last in the lowest bits, so
+   anagrams share it and words of at most 12 letters fit.
+*/
+typedef unsigned long long sigkey;
+extern sigkey vocab_signature(const char *word, unsigned len);
+
+/* The indices of the words of length len with signature sig, i.e., the
+   anagrams of a word, in alphabetical order; *n is set to their number.
+   Returns NULL if out of memory.
+*/
+extern const unsigned *vocab_anagrams(unsigned len, sigkey sig, unsigned *n);
+
+/* A trie of all words: the children of a node are consecutive nodes, one
+   per letter in its mask in alphabetical order, starting at first.
+*/
+struct trie_node {
+  unsigned mask;			/* bit c: child for letter c */
+  unsigned first;			/* index of the first child */
+  unsigned end;				/* number of words that end here */
+};
+
+/* The trie of the words of all lengths; node 0 is the root. Returns NULL
+   if out of memory.
+*/
+extern const struct trie_node *vocab_trie(void);
+
+/* A trie of the signatures of all words, spelled as their sorted letters;
+   end is the number of words with the signature of a node, i.e., of
+   anagrams. Returns NULL if out of memory.
+*/
+extern const struct trie_node *vocab_signature_trie(void);
+
+/* The signatures of words of min_len to max_len letters within a rack of
+   the letters counted in count (per letter 0-25), i.e., the distinct
+   sub-multisets of the rack that have anagrams, each once: stored in
+   sigs and their lengths in lens, which need room for 1 << MAX_WORD_LEN.
+   *words is set to the number of words they have. Returns the number of
+   signatures, or -1 as soon as there are more than max_words words.
+   vocab_signature_trie() must have been called.
+*/
+extern int vocab_subsignatures(const unsigned count[26], unsigned min_len,
+			       unsigned max_len, unsigned max_words,
+			       sigkey *sigs, unsigned char *lens,
+			       unsigned *words);
+
+/* The child of node n in trie t for letter c (0-25) in its mask. */
+#define trie_child(t, n, c) \
+  ((t)[n].first + __builtin_popcount((t)[n].mask & ((1u << (c)) - 1)))
+
+/* Number of bits set in both bitsets a and b of nb bitwords each. */
+extern unsigned bits_and_count(const bitword *a, const bitword *b,
+			       unsigned nb);
+
+#endif /* VOCAB_H */
@@ -0,0 +1,494 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Wordle-style constraints on the words of a given length.
+
+   The first operand is a template of known letters, e.g. '..A..', that
+   also fixes the word length. Each further operand is a constraint:
+     +LETTERS  the letters must occur somewhere in the word, a repeated
+	       letter at least as many times
+     -LETTERS  the letters must not occur at all
+     L!nm      letter L is not at position n, nor at m (1-based)
+     L=k       letter L occurs exactly k times; L>=k and L<=k likewise
+     GUESS:FB  the feedback FB on a guess: per position G for green (right
+	       letter, right place), Y for yellow (letter elsewhere in the
+	       word) and anything else for grey
+   The known and excluded positions narrow down a bitset over the words of
+   that length via the positional index; the remaining candidates are then
+   checked against precomputed letter-presence masks.
+*/
+
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "vocab.h"
+#include "words.h"
+
+static unsigned wlen;			/* length of the words */
+static char fixed[MAX_WORD_LEN];	/* known letter at pos or 0 */
+static unsigned not_at[MAX_WORD_LEN];	/* bit c: letter c not at pos */
+static unsigned min_count[26];		/* letter occurs at least so often */
+static unsigned max_count[26];		/* and at most so often */
+
+/* Parse a template of known letters; anything else is unknown. */
+static int parse_template(const char *s)
+{
+  unsigned pos, c;
+  wlen = strlen(s);
+  if (wlen < MIN_WORD_LEN || wlen > MAX_WORD_LEN)
+    return 0;
+  for (pos = 0; pos < wlen; pos++)
+    fixed[pos] = isalpha(s[pos]) ? toupper(s[pos]) : 0;
+  for (c = 0; c < 26; c++)
+    max_count[c] = wlen;
+  return 1;
+}
+
+/* Parse guess:feedback into constraints. */
+static int parse_feedback(const char *s)
+{
+  const char *fb = strchr(s, ':');
+  unsigned pos, c, known[26] = { 0 }, grey = 0;
+
+  if (!fb || fb-s != wlen || strlen(fb+1) != wlen)
+    return 0;
+  for (pos = 0; pos < wlen; pos++) {
+    if (!isalpha(s[pos]))
+      return 0;
+    c = toupper(s[pos])-'A';
+    switch (toupper(fb[1+pos])) {
+    case 'G':
+      fixed[pos] = c+'A';
+      known[c]++;
+      break;
+    case 'Y':
+      not_at[pos] |= 1u << c;
+      known[c]++;
+      break;
+    default:
+      not_at[pos] |= 1u << c;
+      grey |= 1u << c;
+      break;
+    }
+  }
+  /* A grey letter means no more occurrences than shown green/yellow: */
+  for (c = 0; c < 26; c++) {
+    if (known[c] > min_count[c])
+      min_count[c] = known[c];
+    if ((grey >> c) & 1 && known[c] < max_count[c])
+      max_count[c] = known[c];
+  }
+  return 1;
+}
+
+/* Parse a constraint operand; see above. */
+static int parse_constraint(const char *s)
+{
+  if (strchr(s, ':'))
+    return parse_feedback(s);
+
+  if (*s == '+' || *s == '-') {
+    int include = *s++ == '+';
+    unsigned times[26] = { 0 };
+    for (; *s; s++) {
+      if (!isalpha(*s))
+	return 0;
+      unsigned c = toupper(*s)-'A';
+      if (include) {
+	/* A repeated letter must occur that many times: */
+	if (++times[c] > min_count[c])
+	  min_count[c] = times[c];
+      }
+      else
+	max_count[c] = 0;
+    }
+    return 1;
+  }
+  if (!isalpha(*s))
+    return 0;
+  unsigned c = toupper(*s++)-'A';
+  if (*s == '!') {
+    for (s++; *s; s++) {
+      unsigned pos = *s - '1';
+      if (!isdigit(*s) || pos >= wlen)
+	return 0;
+      not_at[pos] |= 1u << c;
+    }
+    /* Not here means somewhere else: */
+    if (!min_count[c])
+      min_count[c] = 1;
+    return 1;
+  }
+  int op = *s++;
+  if (op != '=' && ((op != '<' && op != '>') || *s++ != '='))
+    return 0;
+  if (!isdigit(*s))
+    return 0;
+  unsigned k = atoi(s);
+  if (op != '<' && k > min_count[c])
+    min_count[c] = k;
+  if (op != '>' && k < max_count[c])
+    max_count[c] = k;
+  return 1;
+}
+
+/* How many times letter c occurs in word. */
+static unsigned count_letter(const char *word, unsigned c)
+{
+  unsigned n = 0;
+  for (; *word; word++)
+    n += (unsigned) (*word-'A') == c;
+  return n;
+}
+
+/* Set cand to the words of length wlen that satisfy all constraints.
+   Returns their number.
+*/
+static unsigned candidates(bitword *cand)
+{
+  unsigned nb = vocab_bitwords(wlen), n = vocab_count(wlen), i, pos, c;
+  const struct letter_masks *lm = vocab_masks(wlen);
+  const char **wl = vocab_words(wlen);
+
+  if (!lm || !vocab_posbits(wlen, 0, 0))
+    return 0;
+  for (i = 0; i < nb; i++)
+    cand[i] = ~0ULL;
+  if (n % BITWORD_BITS)
+    cand[nb-1] = (1ULL << (n % BITWORD_BITS)) - 1;
+
+  /* Positional constraints on the bitset: */
+  for (pos = 0; pos < wlen; pos++) {
+    if (fixed[pos]) {
+      const bitword *pb = vocab_posbits(wlen, pos, fixed[pos]-'A');
+      for (i = 0; i < nb; i++)
+	cand[i] &= pb[i];
+    }
+    for (c = 0; c < 26; c++)
+      if ((not_at[pos] >> c) & 1) {
+	const bitword *pb = vocab_posbits(wlen, pos, c);
+	for (i = 0; i < nb; i++)
+	  cand[i] &= ~pb[i];
+      }
+  }
+
+  /* Letter counts as masks; counts beyond 3 need counting: */
+  unsigned need1 = 0, need2 = 0, need3 = 0, none = 0, max1 = 0, max2 = 0;
+  unsigned count = 0;
+  for (c = 0; c < 26; c++) {
+    unsigned bit = 1u << c;
+    if (min_count[c] >= 1) need1 |= bit;
+    if (min_count[c] >= 2) need2 |= bit;
+    if (min_count[c] >= 3) need3 |= bit;
+    if (min_count[c] > 3 || (max_count[c] >= 3 && max_count[c] < wlen))
+      count |= bit;
+    if (max_count[c] == 0) none |= bit;
+    if (max_count[c] == 1) max1 |= bit;
+    if (max_count[c] == 2) max2 |= bit;
+  }
+
+  unsigned total = 0;
+  for (i = 0; i < nb; i++) {
+    bitword b = cand[i];
+    while (b) {
+      unsigned k = i * BITWORD_BITS + __builtin_ctzll(b);
+      const struct letter_masks *m = &lm[k];
+      int ok = (m->once & need1) == need1 && (m->twice & need2) == need2
+	&& (m->thrice & need3) == need3 && !(m->once & none)
+	&& !(m->twice & max1) && !(m->thrice & max2);
+      if (ok && count) {
+	unsigned todo = count;
+	while (ok && todo) {
+	  c = __builtin_ctz(todo);
+	  todo &= todo-1;
+	  unsigned n = count_letter(wl[k], c);
+	  ok = n >= min_count[c] && n <= max_count[c];
+	}
+      }
+      if (ok)
+	total++;
+      else
+	cand[i] &= ~(1ULL << (k % BITWORD_BITS));
+      b &= b-1;
+    }
+  }
+  return total;
+}
+
+/* Best guess by expected information.
+   The feedback on a guess splits the candidates into classes, one per
+   feedback pattern; the best guess maximizes the entropy of that split.
+   Every word of the length is a possible guess, not just the candidates.
+   The guesses are divided over num_threads threads.
+*/
+#define NUM_PATTERNS 531441		/* 3^12: feedback patterns */
+
+static unsigned char (*padded)[16];	/* words padded with zeros */
+static unsigned char (*counts)[26];	/* letter counts of the words */
+static unsigned pow3[MAX_WORD_LEN];
+static const struct letter_masks *masks;
+static unsigned *cand_list;		/* indices of the candidates */
+static unsigned num_cand;
+static double *entropy;			/* per guess */
+static double *plogp;			/* n log2 n for n <= num_cand */
+static unsigned next_guess;		/* shared work counter */
+static unsigned num_guesses;
+static int out_of_memory;		/* set by a worker */
+
+/* The feedback on guess g for target t as a base-3 number: digit pos is
+   2 for green, 1 for yellow and 0 for grey. Greens are found comparing all
+   positions at once; yellows need only be counted for letters the words
+   share, using the letter counts of the target.
+*/
+static unsigned feedback(unsigned g, unsigned t)
+{
+  const unsigned char *gw = padded[g], *tw = padded[t];
+  unsigned shared = masks[g].once & masks[t].once;
+  unsigned green, pos, code = 0;
+
+  /* No letters in common means all grey: */
+  if (!shared)
+    return 0;
+#ifdef __SSE2__
+  __m128i eq = _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) gw),
+			      _mm_load_si128((const __m128i *) tw));
+  green = _mm_movemask_epi8(eq) & ((1u << wlen) - 1);
+#else
+  for (green = pos = 0; pos < wlen; pos++)
+    green |= (gw[pos] == tw[pos]) << pos;
+#endif
+  /* Occurrences in the target not matched by a green, per shared letter: */
+  unsigned char left[26];
+  unsigned todo = shared, bits;
+  while (todo) {
+    unsigned c = __builtin_ctz(todo);
+    todo &= todo-1;
+    left[c] = counts[t][c];
+  }
+  for (bits = green; bits; bits &= bits-1) {
+    pos = __builtin_ctz(bits);
+    left[gw[pos]-'A']--;
+    code += 2 * pow3[pos];
+  }
+  /* Yellows go to the leftmost ones first: */
+  for (pos = 0; pos < wlen; pos++) {
+    unsigned c = gw[pos]-'A';
+    if (!((green >> pos) & 1) && (shared >> c) & 1 && left[c]) {
+      left[c]--;
+      code += pow3[pos];
+    }
+  }
+  return code;
+}
+
+static void *entropy_worker(void *arg)
+{
+  unsigned *hist = calloc(NUM_PATTERNS, sizeof(*hist));
+  unsigned *used = malloc(num_cand * sizeof(*used));
+  (void) arg;
+  if (!hist || !used) {
+    out_of_memory = 1;
+    free(hist);
+    free(used);
+    return NULL;
+  }
+  for (;;) {
+    unsigned g = __atomic_fetch_add(&next_guess, 1, __ATOMIC_RELAXED);
+    if (g >= num_guesses)
+      break;
+    unsigned i, n = 0;
+    for (i = 0; i < num_cand; i++) {
+      unsigned code = feedback(g, cand_list[i]);
+      if (!hist[code]++)
+	used[n++] = code;
+    }
+    /* H = log2 N - (1/N) sum n_k log2 n_k */
+    double sum = 0;
+    for (i = 0; i < n; i++) {
+      sum += plogp[hist[used[i]]];
+      hist[used[i]] = 0;
+    }
+    entropy[g] = log2(num_cand) - sum / num_cand;
+  }
+  free(hist);
+  free(used);
+  return NULL;
+}
+
+/* Order of guesses: higher entropy first, then candidates first. */
+static bitword *cand_set;
+static int guess_cmp(const void *a, const void *b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  if (entropy[x] != entropy[y])
+    return entropy[x] < entropy[y] ? 1 : -1;
+  int cx = (cand_set[x / BITWORD_BITS] >> (x % BITWORD_BITS)) & 1;
+  int cy = (cand_set[y / BITWORD_BITS] >> (y % BITWORD_BITS)) & 1;
+  if (cx != cy)
+    return cy - cx;
+  return x < y ? -1 : x > y;
+}
+
+/* Path of the cache file for the opening move of words of length len. */
+static const char *cache_path(unsigned len)
+{
+  static char path[512];
+  const char *dir = getenv("WORDS_CACHE");
+  if (dir)
+    snprintf(path, sizeof(path), "%s/opening-%u", dir, len);
+  else
+  if ((dir = getenv("HOME")))
+    snprintf(path, sizeof(path), "%s/.cache/words-opening-%u", dir, len);
+  else
+    return NULL;
+  return path;
+}
+
+/* Print the best guesses; the opening move, without any constraints, is
+   cached because it is the same every time and costs the most.
+*/
+static int best_guesses(bitword *cand, unsigned n)
+{
+  unsigned count = vocab_count(wlen), i;
+  unsigned show = max_results ? max_results : 10;
+  const char **wl = vocab_words(wlen);
+  const char *path = n == count ? cache_path(wlen) : NULL;
+  char line[128];
+  FILE *fp;
+
+  if (path && (fp = fopen(path, "r"))) {
+    unsigned cached_count, cached_show;
+    if (fgets(line, sizeof(line), fp)
+	&& sscanf(line, "words %u %u", &cached_count, &cached_show) == 2
+	&& cached_count == count && cached_show >= show) {
+      for (i = 0; i < show && fgets(line, sizeof(line), fp); i++)
+	fputs(line, stdout);
+      fclose(fp);
+      return 0;
+    }
+    fclose(fp);
+  }
+
+  if (!n)
+    return 0;
+  padded = aligned_alloc(16, count * sizeof(*padded));
+  cand_list = malloc(n * sizeof(*cand_list));
+  entropy = malloc(count * sizeof(*entropy));
+  plogp = malloc((n+1) * sizeof(*plogp));
+  unsigned *order = malloc(count * sizeof(*order));
+  masks = vocab_masks(wlen);
+  counts = calloc(count, sizeof(*counts));
+  if (!padded || !cand_list || !entropy || !plogp || !order || !masks
+      || !counts)
+    goto out_of_memory;
+  memset(padded, 0, count * sizeof(*padded));
+  for (i = 0; i < count; i++) {
+    unsigned pos;
+    memcpy(padded[i], wl[i], wlen);
+    for (pos = 0; pos < wlen; pos++)
+      counts[i][wl[i][pos]-'A']++;
+  }
+  for (i = 0; i < wlen; i++)
+    pow3[i] = i ? 3 * pow3[i-1] : 1;
+  num_cand = 0;
+  for (i = 0; i < count; i++)
+    if ((cand[i / BITWORD_BITS] >> (i % BITWORD_BITS)) & 1)
+      cand_list[num_cand++] = i;
+  for (i = 0; i <= n; i++)
+    plogp[i] = i ? i * log2(i) : 0;
+
+  num_guesses = count;
+  next_guess = 0;
+  unsigned t, nt = num_threads ? num_threads : 1;
+  pthread_t *tid = malloc(nt * sizeof(*tid));
+  for (t = 1; tid && t < nt; t++)
+    if (pthread_create(&tid[t], NULL, entropy_worker, NULL))
+      break;
+  entropy_worker(NULL);
+  while (tid && --t > 0)
+    pthread_join(tid[t], NULL);
+  free(tid);
+  if (out_of_memory)
+    goto out_of_memory;
+
+  for (i = 0; i < count; i++)
+    order[i] = i;
+  cand_set = cand;
+  qsort(order, count, sizeof(*order), guess_cmp);
+
+  fp = path ? fopen(path, "w") : NULL;
+  if (fp)
+    fprintf(fp, "words %u %u\n", count, show);
+  for (i = 0; i < show && i < count; i++) {
+    unsigned g = order[i];
+    int is_cand = (cand[g / BITWORD_BITS] >> (g % BITWORD_BITS)) & 1;
+    snprintf(line, sizeof(line), "%s %.4f%s\n", wl[g], entropy[g],
+	     is_cand ? " *" : "");
+    fputs(line, stdout);
+    if (fp)
+      fputs(line, fp);
+  }
+  if (fp)
+    fclose(fp);
+  free(padded);
+  free(counts);
+  free(cand_list);
+  free(entropy);
+  free(plogp);
+  free(order);
+  return 0;
+
+ out_of_memory:
+  fprintf(stderr, "(E) Out of memory\n");
+  free(padded);
+  free(counts);
+  free(cand_list);
+  free(entropy);
+  free(plogp);
+  free(order);
+  return 6;
+}
+
+int wordle_main(int argc, char *argv[])
+{
+  if (argc < 2 || !parse_template(argv[1])) {
+    fprintf(stderr, "(E) Expect a template of %u to %u positions\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN);
+    return 3;
+  }
+  int i;
+  for (i = 2; i < argc; i++)
+    if (!parse_constraint(argv[i])) {
+      fprintf(stderr, "(E) Invalid constraint: %s\n", argv[i]);
+      return 3;
+    }
+
+  unsigned nb = vocab_bitwords(wlen);
+  bitword *cand = malloc(nb * sizeof(*cand));
+  if (!cand) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
+  unsigned n = candidates(cand);
+  fprintf(stderr, "%u candidate%s\n", n, n == 1 ? "" : "s");
+  if (wordle_guess) {
+    int rc = best_guesses(cand, n);
+    free(cand);
+    return rc;
+  }
+  const char **wl = vocab_words(wlen);
+  unsigned k;
+  for (k = 0; k < nb * BITWORD_BITS; k++)
+    if ((cand[k / BITWORD_BITS] >> (k % BITWORD_BITS)) & 1) {
+      fputs(wl[k], stdout);
+      fputc('\n', stdout);
+    }
+  free(cand);
+  return 0;
+}
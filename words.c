@@ -14,9 +14,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
 
-/* defines wordlist a vocabulary of MIN_WORD_LEN-MAX_WORD_LEN char words: */
-#include "wordlist.h"
+/* vocabulary of MIN_WORD_LEN-MAX_WORD_LEN char words: */
+#include "vocab.h"
+#include "template.h"
+#include "words.h"
 
 /* Unlikely first letters of a word: */
 static const char unlikely_first[] = "X";
@@ -86,44 +89,165 @@ static const char *unlikely_combos[] = {
   /*Z*/ "BCDFGHJKLMNPQRSTUVWXYZ"
 };
 
-#define MIN_WORD_LEN 2
 static unsigned min_word_len;
-#define MAX_WORD_LEN 12
 static unsigned max_word_len;
 /* Available letters (A-Z) and their multiplicity; any order. */
 static char letters[26+1];	       /* distinct, sorted upper-case letters */
-static char *pattern;		       /* upper-case letters or . */
-static unsigned pattern_len;	       /* length of pattern */
+static char *pattern;		       /* word template, if any */
+static struct dfa tpl;		       /* pattern compiled */
+static short tpl_state[MAX_WORD_LEN+1];/* tpl state after build[0..pos) */
 static unsigned num_letters;	       /* number of letters in letters[] */
 static unsigned howmany[26];	       /* multiplicity of each letter */
+static unsigned blanks;		       /* number of spare blank tiles */
+static const char *candidates;	       /* letters to try at each position */
+static char from_blank[MAX_WORD_LEN];  /* 1 if build[pos] is a blank */
+static int out_of_memory;	       /* an index could not be built */
 
-static int lookup(const char *word, unsigned len)
+/* Letter values for scoring; default are the English Scrabble tile values. */
+int letter_value[26] = {
+  /*A*/ 1, /*B*/ 3, /*C*/ 3, /*D*/ 2, /*E*/ 1, /*F*/ 4, /*G*/ 2, /*H*/ 4,
+  /*I*/ 1, /*J*/ 8, /*K*/ 5, /*L*/ 1, /*M*/ 3, /*N*/ 1, /*O*/ 1, /*P*/ 3,
+  /*Q*/10, /*R*/ 1, /*S*/ 1, /*T*/ 1, /*U*/ 1, /*V*/ 4, /*W*/ 4, /*X*/ 8,
+  /*Y*/ 4, /*Z*/10
+};
+/* Extra score for a word of a certain length, e.g. a 7-letter bingo: */
+static int length_bonus[MAX_WORD_LEN+1];
+/* Letter indices 0-25 ordered on decreasing letter value: */
+static unsigned value_order[26];
+
+/* Best-scoring mode keeps the best_max highest scoring words found so far.
+   The score of the worst of those is the bar any other branch must beat.
+*/
+struct scored {
+  int score;
+  char word[MAX_WORD_LEN+1];
+};
+static unsigned best_max;	       /* 0: not scoring; list all words */
+static unsigned best_num;	       /* number of entries in best[] */
+static struct scored *best;	       /* sorted on decreasing score */
+static int build_score;		       /* value of the letters in build */
+
+/* Options for the puzzle modes; see words.h: */
+unsigned num_threads;
+unsigned max_results;
+int wordle_guess;
+const char *hangman_guessed;
+const char *bee_centre;
+int validate_invalid;
+
+/* Upper bound on the value of n more letters taken from the ones still
+   available, i.e., the sum of the n most valuable ones.
+*/
+static int best_fill(unsigned n)
 {
-  /* Get the list of words of length len: */
-  const char **wl = wordlist[len-MIN_WORD_LEN];
-#if 1
-  /* Since words are stored sorted, using binary search. */
-  int i = 0, j = wordlist_len[len-MIN_WORD_LEN];
-
-  /* Binary search: */
-  while (i < j) {
-    int k = (i + j) >> 1 /* / 2 */;
-    int cmp = strcmp(word, wl[k]);
-    if (!cmp)
-      return 1;
-    if (cmp < 0)
-      j = k;
-    else
-      i = k + 1;
+  int sum = 0;
+  unsigned spare = blanks;
+  unsigned i;
+  for (i = 0; n && i < 26; i++) {
+    unsigned apos = value_order[i];
+    if (letter_value[apos] < 0 && spare) {
+      /* Rather use the blanks, that are worth 0: */
+      unsigned k = spare < n ? spare : n;
+      n -= k;
+      spare = 0;
+      if (!n)
+	break;
+    }
+    unsigned k = howmany[apos] < n ? howmany[apos] : n;
+    sum += (int) k * letter_value[apos];
+    n -= k;
   }
-#else
-  /* slower linear search */
+  return sum;
+}
+
+/* Insert word in best[] if its score beats the worst one kept. */
+static void record(const char *word, int score)
+{
   unsigned i;
-  for (i = 0; wl[i]; i++)
-    if (!strcmp(wl[i], word))
-      return 1;
-#endif
-  return 0;
+  if (best_num == best_max) {
+    if (score <= best[best_num-1].score)
+      return;
+    /* Drop the worst one: */
+    best_num--;
+  }
+  for (i = best_num; i > 0 && best[i-1].score < score; i--)
+    best[i] = best[i-1];
+  best[i].score = score;
+  strcpy(best[i].word, word);
+  best_num++;
+}
+
+/* Output the best words kept and start afresh. */
+static unsigned print_best(void)
+{
+  unsigned i, n = best_num;
+  for (i = 0; i < best_num; i++)
+    printf("%s %d\n", best[i].word, best[i].score);
+  best_num = 0;
+  return n;
+}
+
+/* Output (or record) the found word in build; blanks are shown in
+   lower-case.
+*/
+static void found(const char build[], unsigned len)
+{
+  char word[MAX_WORD_LEN+1];
+  unsigned k;
+  for (k = 0; k < len; k++)
+    word[k] = from_blank[k] ? tolower(build[k]) : build[k];
+  word[len] = '\0';
+  if (best_max)
+    record(word, build_score + length_bonus[len]);
+  else {
+    fputs(word, stdout);
+    fputc('\n', stdout);
+  }
+}
+
+static void iterate(unsigned len, char build[], unsigned pos);
+
+/* The pattern in state allows only letters that lead to a state from where
+   it can still match a word with rest more letters.
+*/
+static unsigned tpl_allowed(int state, unsigned rest)
+{
+  unsigned c, allowed = 0;
+  for (c = 0; c < 26; c++) {
+    int to = tpl.next[state][c];
+    if (to != DFA_DEAD && dfa_can_accept(&tpl, to, rest))
+      allowed |= 1u << c;
+  }
+  return allowed;
+}
+
+/* Put letter next at build[pos] and continue at pos+1.
+   Uses up one of the available letters next or else one of the blanks.
+   Only resorting to a blank when the letter has run out makes sure each
+   word is generated just once.
+*/
+static void place(unsigned len, char build[], unsigned pos, char next)
+{
+  unsigned apos = next-'A';
+  build[pos] = next;
+  if (howmany[apos]) {
+    /* Exclude it from subsequent picks: */
+    howmany[apos]--;
+    build_score += letter_value[apos];
+    iterate(len, build, pos+1);
+    /* Restore availability: */
+    build_score -= letter_value[apos];
+    howmany[apos]++;
+  }
+  else
+  if (blanks) {
+    /* A blank scores nothing: */
+    blanks--;
+    from_blank[pos] = 1;
+    iterate(len, build, pos+1);
+    from_blank[pos] = 0;
+    blanks++;
+  }
 }
 
 /* Generate all words of length len in build.
@@ -133,49 +257,50 @@ static void iterate(unsigned len, char build[], unsigned pos)
 {
   /* Check if constructed word of required length: */
   if (pos == len) {
-#if 0
-    /* Match against pattern, if any: */
-    if (pattern_len) {
-      unsigned k;
-      for (k = 0; k < pos; k++)
-	if (pattern[k] != '.' && pattern[k] != build[k])
-	  return;
-    }
-#endif
+    /* Pattern, if any, matches for sure: see below. */
     /* Match against vocabulary: */
     build[pos] = '\0';
-    if (lookup(build, len)) {
-      fputs(build, stdout);
-      fputc('\n', stdout);
-    }
+    if (vocab_lookup(build, len))
+      found(build, len);
     return;
   }
   /* Here: pos < len; not done yet; need more letters appended. */
 
-  char next;
-#if 1
-  /* See if pattern decides next letter: */
-  if (pattern_len && (next = pattern[pos]) != '.') {
-    /* letter at this pos is prescribed: must be next. */
-    unsigned apos = next - 'A';
-    /* Are there any of this letter still available? */
-    if (!howmany[apos]) return;
-    build[pos] = next;
-    /* Exclude it from subsequent picks: */
-    howmany[apos]--;
-    iterate(len, build, pos+1);
-    /* Restore availability: */
-    howmany[apos]++;
+  /* No use going on if no word starts like this: */
+  unsigned lo, hi;
+  if (pos > 1 && !vocab_prefix_range(len, build, pos, &lo, &hi))
+    return;
+
+  /* Prune if even the best completion cannot beat the words kept: */
+  if (best_max && best_num == best_max
+      && build_score + length_bonus[len] + best_fill(len-pos)
+         <= best[best_num-1].score)
     return;
+
+  char next;
+  unsigned allowed = (1u << 26) - 1;
+  int state = 0;
+  if (pattern) {
+    state = tpl_state[pos];
+    allowed = tpl_allowed(state, len-pos-1);
+    if (!allowed)
+      return;
+    /* See if pattern decides next letter: */
+    if (!(allowed & (allowed-1))) {
+      /* letter at this pos is prescribed: must be next. */
+      next = 'A' + __builtin_ctz(allowed);
+      tpl_state[pos+1] = tpl.next[state][next-'A'];
+      place(len, build, pos, next);
+      return;
+    }
   }
-#endif
   /* Consider all letters as the next letter: */
   unsigned i;
-  for (i = 0; i < num_letters; i++) {
-    next = letters[i];
+  for (i = 0; (next = candidates[i]); i++) {
     unsigned apos = next-'A';
-    /* Are there any of this letter still available? */
-    if (!howmany[apos]) continue;
+    if (!((allowed >> apos) & 1)) continue;
+    /* Are there any of this letter (or blanks) still available? */
+    if (!howmany[apos] && !blanks) continue;
 
     /* check whether next makes sense as first letter: */
     if (pos == 0 && strchr(unlikely_first, next)) continue;
@@ -184,25 +309,497 @@ static void iterate(unsigned len, char build[], unsigned pos)
     /* check whether build[pos-1] and next are likely: */
     if (pos > 0 && strchr(unlikely_combos[build[pos-1]-'A'], next)) continue;
 
-    build[pos] = next;
-    /* Exclude it from subsequent picks: */
-    howmany[apos]--;
-    iterate(len, build, pos+1);
-    /* Restore availability: */
-    howmany[apos]++;
+    if (pattern)
+      tpl_state[pos+1] = tpl.next[state][apos];
+    place(len, build, pos, next);
   }
 }
 
+static int str_cmp(const void *a, const void *b)
+{
+  return strcmp(*(const char **) a, *(const char **) b);
+}
+
+/* Check whether iterate() would try the letters of word of length len:
+   the unlikely first and last letters and letter pairs are only avoided
+   at positions the pattern does not prescribe.
+*/
+static int likely(const char *word, unsigned len)
+{
+  int state = 0;
+  unsigned pos;
+  for (pos = 0; pos < len; pos++) {
+    char next = word[pos];
+    unsigned allowed = pattern ? tpl_allowed(state, len-pos-1) : ~0u;
+    if (allowed & (allowed-1)) {
+      if (pos == 0 && strchr(unlikely_first, next)) return 0;
+      if (pos == len-1 && strchr(unlikely_last, next)) return 0;
+      if (pos > 0 && strchr(unlikely_combos[word[pos-1]-'A'], next)) return 0;
+    }
+    if (pattern)
+      state = tpl.next[state][next-'A'];
+  }
+  return 1;
+}
+
+/* Check whether word of length len can be made from the available letters
+   and blanks, taking them like place() does. Sets from_blank[] and
+   build_score for found().
+*/
+static int take(const char *word, unsigned len)
+{
+  unsigned have[26], spare = blanks, pos;
+  memcpy(have, howmany, sizeof(have));
+  build_score = 0;
+  for (pos = 0; pos < len; pos++) {
+    unsigned apos = word[pos]-'A';
+    from_blank[pos] = !have[apos];
+    if (have[apos]) {
+      have[apos]--;
+      build_score += letter_value[apos];
+    }
+    else
+    if (spare)
+      spare--;
+    else
+      return 0;
+  }
+  return 1;
+}
+
+/* Words of length len for a pattern that ends in fixed letters.
+   Rather than generating all prefixes only to find out the last letters
+   do not fit, filter the range of words that have that suffix.
+*/
+static void suffix_words(unsigned len)
+{
+  unsigned lo, hi, i, n = 0;
+  const char **rl;
+  if (!dfa_can_accept(&tpl, 0, len))
+    return;
+  if (!(rl = vocab_reversed(len))) {
+    out_of_memory = 1;
+    return;
+  }
+  if (!vocab_suffix_range(len, tpl.suffix, strlen(tpl.suffix), &lo, &hi))
+    return;
+  const char **match = malloc((hi-lo) * sizeof(*match));
+  if (!match) {
+    out_of_memory = 1;
+    return;
+  }
+  for (i = lo; i < hi; i++)
+    if (dfa_match(&tpl, rl[i]) && likely(rl[i], len) && take(rl[i], len))
+      match[n++] = rl[i];
+  /* Restore alphabetical order: */
+  qsort(match, n, sizeof(*match), str_cmp);
+  for (i = 0; i < n; i++) {
+    take(match[i], len);
+    found(match[i], len);
+  }
+  free(match);
+  memset(from_blank, 0, sizeof(from_blank));
+  build_score = 0;
+}
+
+/* Words of length len without a pattern by scanning the letter counts of
+   all words of that length against those of the letters and blanks
+   available (vocab_rack_scan()), rather than by trying letter after
+   letter. Returns 0 if out of memory.
+*/
+static int scan_words(unsigned len)
+{
+  struct letter_counts rack;
+  unsigned *match = malloc((vocab_count(len)+1) * sizeof(*match));
+  unsigned i, n;
+
+  if (!match)
+    return 0;
+  memset(&rack, 0, sizeof(rack));
+  for (i = 0; i < 26; i++)
+    rack.n[i] = howmany[i] < 255 ? howmany[i] : 255;
+  n = vocab_rack_scan(len, &rack, blanks, match);
+  if (n == (unsigned) -1) {
+    free(match);
+    return 0;
+  }
+  const char **wl = vocab_words(len);
+  for (i = 0; i < n; i++)
+    if (likely(wl[match[i]], len) && take(wl[match[i]], len))
+      found(wl[match[i]], len);
+  memset(from_blank, 0, sizeof(from_blank));
+  build_score = 0;
+  free(match);
+  return 1;
+}
+
+/* Constraint-ordered filling of a word of length fill_len.
+   Positions are not filled left to right: each step takes the open
+   position that has the fewest letters left that occur there in any of
+   the candidate words, i.e., the most selective one. The candidates are a
+   bitset over the words of that length narrowed down by the positional
+   index with every letter placed, so a dead end is seen right away no
+   matter where in the word the fixed letters of the pattern are.
+*/
+static unsigned fill_len;
+static unsigned fill_nb;		/* bitwords per candidate set */
+static unsigned fill_mask[MAX_WORD_LEN];/* letters pattern allows at pos */
+static int fill_open[MAX_WORD_LEN];	/* 1 if pos still to be filled */
+static bitword *fill_sets;		/* candidates per depth */
+static unsigned *fill_found;		/* indices of words found */
+static unsigned fill_num;
+
+/* Check whether the bitsets a and b have a word in common. */
+static int intersects(const bitword *a, const bitword *b, unsigned nb)
+{
+  unsigned i;
+  for (i = 0; i < nb; i++)
+    if (a[i] & b[i])
+      return 1;
+  return 0;
+}
+
+static void fill(unsigned depth, const bitword *cand)
+{
+  unsigned nb = fill_nb, i;
+
+  if (depth == fill_len) {
+    /* All positions placed: cand holds the word, if any. */
+    const char **wl = vocab_words(fill_len);
+    for (i = 0; i < nb; i++) {
+      bitword b = cand[i];
+      while (b) {
+	unsigned k = i * BITWORD_BITS + __builtin_ctzll(b);
+	b &= b-1;
+	if (dfa_match(&tpl, wl[k]) && likely(wl[k], fill_len))
+	  fill_found[fill_num++] = k;
+      }
+    }
+    return;
+  }
+
+  /* Letters still available: */
+  unsigned avail = 0, c;
+  for (c = 0; c < 26; c++)
+    if (howmany[c] || blanks)
+      avail |= 1u << c;
+
+  /* Find the most selective open position: */
+  unsigned pos, best_pos = 0, best_letters = 0, best_count = 27;
+  for (pos = 0; pos < fill_len; pos++) {
+    if (!fill_open[pos])
+      continue;
+    unsigned letters = 0, todo = fill_mask[pos] & avail;
+    while (todo) {
+      c = __builtin_ctz(todo);
+      todo &= todo-1;
+      if (intersects(cand, vocab_posbits(fill_len, pos, c), nb))
+	letters |= 1u << c;
+    }
+    unsigned count = __builtin_popcount(letters);
+    if (!count)
+      return;
+    if (count < best_count) {
+      best_count = count;
+      best_pos = pos;
+      best_letters = letters;
+    }
+  }
+
+  bitword *next = fill_sets + (depth+1) * nb;
+  fill_open[best_pos] = 0;
+  while (best_letters) {
+    c = __builtin_ctz(best_letters);
+    best_letters &= best_letters-1;
+    const bitword *pb = vocab_posbits(fill_len, best_pos, c);
+    for (i = 0; i < nb; i++)
+      next[i] = cand[i] & pb[i];
+    if (howmany[c]) {
+      howmany[c]--;
+      fill(depth+1, next);
+      howmany[c]++;
+    }
+    else {
+      blanks--;
+      fill(depth+1, next);
+      blanks++;
+    }
+  }
+  fill_open[best_pos] = 1;
+}
+
+static int uint_cmp(const void *a, const void *b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  return x < y ? -1 : x > y;
+}
+
+/* Words of length len by constraint-ordered filling. Returns 0 if the
+   positional index is not available.
+*/
+static int fill_words(unsigned len)
+{
+  unsigned nb = vocab_bitwords(len), n = vocab_count(len), i, pos;
+
+  if (!vocab_posbits(len, 0, 0))
+    return 0;
+  fill_sets = malloc((len+1) * nb * sizeof(*fill_sets));
+  fill_found = malloc(n * sizeof(*fill_found));
+  if (!fill_sets || !fill_found) {
+    free(fill_sets);
+    free(fill_found);
+    return 0;
+  }
+  fill_len = len;
+  fill_nb = nb;
+  fill_num = 0;
+  /* All words of this length to start with: */
+  for (i = 0; i < nb; i++)
+    fill_sets[i] = ~0ULL;
+  if (n % BITWORD_BITS)
+    fill_sets[nb-1] = (1ULL << (n % BITWORD_BITS)) - 1;
+  for (pos = 0; pos < len; pos++)
+    fill_open[pos] = 1;
+  fill(0, fill_sets);
+
+  /* Words found in alphabetical order: */
+  const char **wl = vocab_words(len);
+  qsort(fill_found, fill_num, sizeof(*fill_found), uint_cmp);
+  for (i = 0; i < fill_num; i++) {
+    take(wl[fill_found[i]], len);
+    found(wl[fill_found[i]], len);
+  }
+  memset(from_blank, 0, sizeof(from_blank));
+  build_score = 0;
+  free(fill_sets);
+  free(fill_found);
+  return 1;
+}
+
+/* Letters the pattern allows at each position of a word of length len;
+   returns whether any position after the fixed prefix is restricted.
+*/
+static int pattern_masks(unsigned len)
+{
+  /* States reachable after pos letters that can still end in time: */
+  unsigned char reach[DFA_MAX_STATES], to_reach[DFA_MAX_STATES];
+  unsigned pos, s, c, np = strlen(tpl.prefix);
+  int restricted = 0;
+
+  memset(reach, 0, sizeof(reach));
+  reach[0] = 1;
+  for (pos = 0; pos < len; pos++) {
+    memset(to_reach, 0, sizeof(to_reach));
+    fill_mask[pos] = 0;
+    for (s = 0; s < tpl.num_states; s++) {
+      if (!reach[s])
+	continue;
+      unsigned allowed = tpl_allowed(s, len-pos-1);
+      fill_mask[pos] |= allowed;
+      for (c = 0; c < 26; c++)
+	if ((allowed >> c) & 1)
+	  to_reach[tpl.next[s][c]] = 1;
+    }
+    memcpy(reach, to_reach, sizeof(reach));
+    if (pos >= np && fill_mask[pos] != (1u << 26) - 1)
+      restricted = 1;
+  }
+  return restricted;
+}
+
+/* Generate the words of length len. Without a pattern the words are
+   scanned for the ones the letters make. A pattern with a fixed suffix
+   longer than its fixed prefix is answered from the suffix index; a
+   pattern with other constraints further on in the word by
+   constraint-ordered filling; anything else left to right.
+*/
+static void generate(unsigned len, char build[])
+{
+  if (!pattern) {
+    if (!scan_words(len))
+      iterate(len, build, 0);
+  }
+  else
+  if (!dfa_can_accept(&tpl, 0, len))
+    iterate(len, build, 0);
+  else
+  if (strlen(tpl.suffix) > strlen(tpl.prefix))
+    suffix_words(len);
+  else
+  if (!pattern_masks(len) || !fill_words(len))
+    iterate(len, build, 0);
+}
+
 /* Generate all words that can be compose by any combination of the given
    letters with their given multiplicity with a word length from min_word_len
    to and including max_word_len.
 */
-unsigned words(void)
+void words(void)
 {
   char build[MAX_WORD_LEN+1]; /* +1 for terminating NUL. */
   unsigned len;
+
+  if (best_max) {
+    /* Longer words tend to score higher; finding them first sets a high
+       bar early on and so prunes more.
+    */
+    for (len = max_word_len; len >= min_word_len; len--)
+      generate(len, build);
+    print_best();
+    return;
+  }
   for (len = min_word_len; len <= max_word_len; len++)
-    iterate(len, build, 0);
+    generate(len, build);
+}
+
+/* Answer a template without a set of letters straight from the vocabulary.
+   The fixed prefix of the template narrows the words of each length to a
+   range of the sorted list, or a longer fixed suffix to a range of the
+   list sorted on reversal; only the words in that range are matched. As
+   with a set of letters, the words iterate() would not try are left out.
+*/
+static unsigned query(void)
+{
+  unsigned np = strlen(tpl.prefix), ns = strlen(tpl.suffix);
+  unsigned len, total = 0;
+
+  for (len = min_word_len; len <= max_word_len; len++) {
+    if (!dfa_can_accept(&tpl, 0, len))
+      continue;
+    const char **wl;
+    unsigned lo, hi, i, n = 0;
+    if (np >= ns) {
+      wl = vocab_words(len);
+      vocab_prefix_range(len, tpl.prefix, np, &lo, &hi);
+    }
+    else {
+      if (!(wl = vocab_reversed(len))) {
+	out_of_memory = 1;
+	break;
+      }
+      vocab_suffix_range(len, tpl.suffix, ns, &lo, &hi);
+    }
+    if (lo == hi)
+      continue;
+    const char **match = malloc((hi-lo) * sizeof(*match));
+    if (!match) {
+      out_of_memory = 1;
+      break;
+    }
+    for (i = lo; i < hi; i++)
+      if (dfa_match(&tpl, wl[i]) && likely(wl[i], len))
+	match[n++] = wl[i];
+    /* Restore alphabetical order: */
+    if (np < ns)
+      qsort(match, n, sizeof(*match), str_cmp);
+    for (i = 0; i < n; i++) {
+      if (best_max) {
+	const char *p;
+	int score = length_bonus[len];
+	for (p = match[i]; *p; p++)
+	  score += letter_value[*p-'A'];
+	record(match[i], score);
+      }
+      else {
+	fputs(match[i], stdout);
+	fputc('\n', stdout);
+      }
+    }
+    free(match);
+    total += n;
+  }
+  if (best_max)
+    return print_best();
+  return total;
+}
+
+/* Compile pattern into tpl and set the word lengths it allows.
+   Returns 0 if all is well.
+*/
+static int compile_pattern(void)
+{
+  unsigned i;
+  for (i = 0; pattern[i]; i++)
+    pattern[i] = toupper(pattern[i]);
+  const char *msg = dfa_compile(&tpl, pattern);
+  if (msg) {
+    fprintf(stderr, "(E) %s: %s\n", msg, pattern);
+    return 3;
+  }
+  /* Word lengths the pattern can match: */
+  for (min_word_len = MIN_WORD_LEN; min_word_len <= MAX_WORD_LEN;
+       min_word_len++)
+    if (dfa_can_accept(&tpl, 0, min_word_len))
+      break;
+  for (max_word_len = MAX_WORD_LEN; max_word_len >= min_word_len;
+       max_word_len--)
+    if (dfa_can_accept(&tpl, 0, max_word_len))
+      break;
+  if (min_word_len > max_word_len) {
+    fprintf(stderr, "(E) Expect pattern length >= %u and <= %u\n",
+	    MIN_WORD_LEN, MAX_WORD_LEN);
+    return 3;
+  }
+  return 0;
+}
+
+/* Answer templates read from stream, one per line. The results of each
+   are followed by an empty line.
+*/
+static int query_stream(FILE *fp)
+{
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!*line)
+      continue;
+    pattern = line;
+    if (!compile_pattern())
+      query();
+    if (out_of_memory) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    fputc('\n', stdout);
+  }
+  return 0;
+}
+
+/* Parse letter values like "Q10Z10" into letter_value[]. */
+static int parse_values(const char *spec)
+{
+  while (*spec) {
+    if (!isalpha(*spec))
+      return 0;
+    unsigned apos = toupper(*spec++) - 'A';
+    char *end;
+    long value = strtol(spec, &end, 10);
+    if (end == spec)
+      return 0;
+    letter_value[apos] = value;
+    spec = end;
+  }
+  return 1;
+}
+
+/* Parse length bonuses like "7=50,8=50" into length_bonus[]. */
+static int parse_bonuses(const char *spec)
+{
+  while (*spec) {
+    char *end;
+    unsigned long len = strtoul(spec, &end, 10);
+    if (end == spec || *end != '=' || len > MAX_WORD_LEN)
+      return 0;
+    spec = end+1;
+    long bonus = strtol(spec, &end, 10);
+    if (end == spec)
+      return 0;
+    length_bonus[len] = bonus;
+    spec = end;
+    if (*spec == ',')
+      spec++;
+  }
+  return 1;
 }
 
 /* 1: set of letters (multiplicity indicated by repetition)
@@ -213,36 +810,226 @@ unsigned words(void)
 */
 int main(int argc, char *argv[])
 {
+  int (*mode)(int argc, char *argv[]) = NULL;
+  int opt;
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  num_threads = ncpu > 0 ? ncpu : 1;
+  while ((opt = getopt(argc, argv, "+s:v:l:j:n:weg:b:amcoidfxutprkq")) != -1) {
+    switch (opt) {
+    case 's':
+      best_max = atoi(optarg);
+      if (!best_max) {
+	fprintf(stderr, "(E) Expect a positive count for -s\n");
+	return 5;
+      }
+      break;
+    case 'v':
+      if (!parse_values(optarg)) {
+	fprintf(stderr, "(E) Invalid letter values: %s\n", optarg);
+	return 5;
+      }
+      break;
+    case 'l':
+      if (!parse_bonuses(optarg)) {
+	fprintf(stderr, "(E) Invalid length bonuses: %s\n", optarg);
+	return 5;
+      }
+      break;
+    case 'j':
+      num_threads = atoi(optarg);
+      break;
+    case 'n':
+      max_results = atoi(optarg);
+      break;
+    case 'e':
+      wordle_guess = 1;
+      /*FALLTHROUGH*/
+    case 'w':
+      mode = wordle_main;
+      break;
+    case 'g':
+      hangman_guessed = optarg;
+      mode = hangman_main;
+      break;
+    case 'b':
+      bee_centre = optarg;
+      mode = bee_main;
+      break;
+    case 'a':
+      mode = anagram_main;
+      break;
+    case 'm':
+      mode = scrabble_main;
+      break;
+    case 'c':
+      mode = crossword_main;
+      break;
+    case 'o':
+      mode = boggle_main;
+      break;
+    case 'i':
+      mode = isomorph_main;
+      break;
+    case 'd':
+      mode = ladder_main;
+      break;
+    case 'f':
+      mode = fuzzy_main;
+      break;
+    case 'u':
+      validate_invalid = 1;
+      /*FALLTHROUGH*/
+    case 'x':
+      mode = validate_main;
+      break;
+    case 't':
+      mode = hidden_main;
+      break;
+    case 'p':
+      mode = rack_main;
+      break;
+    case 'r':
+      mode = sweep_main;
+      break;
+    case 'k':
+      mode = level_main;
+      break;
+    case 'q':
+      mode = hint_main;
+      break;
+    default:
+      return 5;
+    }
+  }
+  /* Shift the options out of sight; argv[1] is the first operand: */
+  argc -= optind-1;
+  argv += optind-1;
+
+  if (mode && argc > 1)
+    return mode(argc, argv);
+
   if (argc < 2) {
     fputs(
-    "Usage: wow letters [ template | min [ max ]]\n"
-    "   or: wow template\n\n"
+    "Usage: wow [options] letters [ template | min [ max ]]\n"
+    "   or: wow [options] template\n\n"
     "Generate words from a given set of letters and their multiplicity.\n"
     "The first argument is a string of at least 2 letters where multiplicity\n"
     "is indicated by repeating the letters that may be used more than once.\n"
     "For instance 'APORRATL' specifies 6 distinct letters of which both\n"
     "A and R may occur twice in any generated word.\n"
-    "The letters may be in any order and in any case.\n\n"
+    "The letters may be in any order and in any case.\n"
+    "Each ? is a blank that stands for exactly one letter of any kind;\n"
+    "letters made from blanks are shown in lower-case and score nothing.\n"
+    "A first argument with any other character is a template on its own,\n"
+    "and so is one with a ? that no other argument follows.\n\n"
     "A second argument can be either a string that specifies a template\n"
     "for the words or a number that specifies the minimum word length.\n"
     "In the latter case a third argument may be provided that specifies the\n"
     "maximum word length. A template is a pattern string in which any letters\n"
     "are expected to occur at the same positions in the generated words.\n"
-    "Any character but a letter is interpreted as a wildcard.\n"
-    "Example: wow 'APORRATL' 'P...A.' generates the word PORTAL.\n\n"
+    "Classes like [AEIOU] or [^XYZ] restrict a position to some letters.\n"
+    "A * stands for any number of letters, + for at least one and ? for an\n"
+    "optional letter; after a class these apply to the class, e.g. [AEIOU]+.\n"
+    "Anchoring with ^ or $ leaves the other end open: ^UN is the same as UN*\n"
+    "and ING$ the same as *ING.\n"
+    "Any other character but a letter is interpreted as a wildcard.\n"
+    "Example: wow 'APORRATL' 'P...A.' generates the word PORTAL.\n"
+    "A template on its own (without letters) may be followed by min and max\n"
+    "word length, e.g. wow 'UN*' 4 6. Templates are read from stdin, one per\n"
+    "line, if the first argument is -.\n\n"
     "The minimum word length is 2 letters; the maximum is 12.\n"
-    "The program uses a vocabulary of about 50,000 English words.\n"
+    "The program uses a vocabulary of about 50,000 English words.\n\n"
+    "Options:\n"
+    "  -s count    list only the count highest scoring words and their score\n"
+    "  -v values   letter values, e.g. 'Q10Z10'; default Scrabble tile values\n"
+    "  -l bonuses  extra score per word length, e.g. '7=50,8=50'\n"
+    "  -j threads  number of threads for the modes that use them\n"
+    "  -n count    number of results for the modes that rank them\n\n"
+    "Puzzle modes:\n"
+    "  -w template constraints...\n"
+    "     Wordle: words matching a template of known letters like '..A..'\n"
+    "     and constraints +LETTERS (must occur), -LETTERS (must not occur),\n"
+    "     L!nm (letter L not at positions n, m), L=k, L>=k, L<=k (counts)\n"
+    "     and GUESS:FEEDBACK with G(reen), Y(ellow) or other (grey) per letter\n"
+    "  -e template constraints...\n"
+    "     Wordle: the guesses that maximize the expected information (in\n"
+    "     bits) about the candidates of -w; * marks a candidate\n"
+    "  -g guessed word\n"
+    "     Hangman: how many candidates for the partial word like '.A..A.'\n"
+    "     have each letter not guessed yet; - reads 'word guessed' lines\n"
+    "  -b centre letters [ min ]\n"
+    "     Spelling Bee: words of at least min (4) letters from the set that\n"
+    "     may each be used more than once and must contain the centre\n"
+    "     letter; * marks a pangram that uses all letters\n"
+    "  -a phrase [ min [ words ]]\n"
+    "     Anagrams of a phrase made of words of at least min (3) letters,\n"
+    "     at most the given number of words each\n"
+    "  -m board rack\n"
+    "     Scrabble: all moves with the rack (? a blank) on the 15x15 board\n"
+    "     in file board (- for stdin), on decreasing score\n"
+    "  -c grid\n"
+    "     Crossword: fill the grid in file grid (- for stdin) of black (#),\n"
+    "     open (.) and given (letter) squares with words across and down\n"
+    "  -o board [ min ]\n"
+    "     Boggle: words of at least min (3) letters traced through adjacent\n"
+    "     cells of the board given as rows like SERS/PATG/LINE/SERS, Q for\n"
+    "     QU; - reads boards from stdin, one per line, to solve in parallel\n"
+    "  -i pattern [ template ]\n"
+    "     Isomorphs: words with the letter repetitions of the pattern, e.g.\n"
+    "     ABCA or XQJX for THAT, that match the template if given\n"
+    "  -d first [ last ]\n"
+    "     Word ladder: the shortest chain of words from first to last that\n"
+    "     changes one letter at a time, or the words one letter from first\n"
+    "  -f word [ edits ]\n"
+    "     Fuzzy lookup: the words at most edits (2) insertions, deletions or\n"
+    "     substitutions away, closest first; - reads words from stdin\n"
+    "  -x files...\n"
+    "     Validation: the tokens, separated by white space, in the files\n"
+    "     (- for stdin) that are words, one per line\n"
+    "  -u files...\n"
+    "     Validation: the tokens that are not words\n"
+    "  -t text [ min ]\n"
+    "     Hidden words: the words of at least min (3) letters that occur in\n"
+    "     the text (- for stdin) as runs of letters, with their offsets\n"
+    "  -p rack\n"
+    "     Rack neighbours: the anagrams of the rack (=), of the rack plus a\n"
+    "     letter (+L) and minus one of its letters (-L); - reads racks from\n"
+    "     stdin\n"
+    "  -r size [ tiles ]\n"
+    "     Rack sweep: for every rack of size letters drawn from the tiles,\n"
+    "     e.g. 'E12Q0' to change the Scrabble distribution, the number of\n"
+    "     words of each length, as binary records on stdout\n"
+    "  -k size answers [ lengths ]\n"
+    "     Levels: racks of the letters of a word of size letters that make\n"
+    "     a number of words in the range answers, e.g. 10-20, of lengths in\n"
+    "     the range lengths (3-size), listed with those words\n"
+    "  -q rack [ queries... ]\n"
+    "     Hints: per query the words of the rack of a length (5), starting\n"
+    "     with a letter (S), having a letter (+S), both (5S, 5+S) or all (*);\n"
+    "     without queries they are read from stdin\n"
     , stderr);
     return 1;
   }
+  /* Templates read from stdin: */
+  if (!strcmp(argv[1], "-")) {
+    if (best_max && !(best = malloc(best_max * sizeof(*best)))) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    return query_stream(stdin);
+  }
+
   char *input = argv[1]; /* no length bound! */
   unsigned len = strlen(input);
 
-  /* if contains a non-alpha assume it's a pattern and accept no more args */
+  /* if contains a non-alpha assume it's a pattern and accept no more args;
+     a ? is a blank though when a template or lengths follow, as they can
+     only after letters:
+  */
   unsigned i;
   int full_alphabet = 0;
   for (i = 0; i < len; i++) {
-    if (!isalpha(input[i])) {
+    if (!isalpha(input[i]) && (input[i] != '?' || argc == 2)) {
       full_alphabet = 1;
       /* Treat as pattern with full alphabet and unrestricted multi. */
       pattern = input;
@@ -255,7 +1042,7 @@ int main(int argc, char *argv[])
       goto treat_as_pattern;
     }
   }
-  /* Here: all input chars alphabetic. */
+  /* Here: all input chars alphabetic or a blank (?). */
 
   if (len < MIN_WORD_LEN) {
     fprintf(stderr, "(E) Not enough letters; need at least %u\n",
@@ -263,7 +1050,6 @@ int main(int argc, char *argv[])
     return 2;
   }
   pattern = NULL;
-  pattern_len = 0;
   /* len >= MIN_WORD_LEN */
   min_word_len = MIN_WORD_LEN;
   max_word_len = MAX_WORD_LEN;
@@ -311,20 +1097,22 @@ int main(int argc, char *argv[])
     else { /* assume pattern */
       pattern = argv[2];
     treat_as_pattern:
-      pattern_len = strlen(pattern);
-      if (pattern_len < MIN_WORD_LEN || pattern_len > MAX_WORD_LEN) {
-	fprintf(stderr, "(E) Expect pattern length >= %u and <= %u\n",
-		MIN_WORD_LEN, MAX_WORD_LEN);
+      if (compile_pattern())
+	return 3;
+      if (full_alphabet && argc > 2 && !isdigit(argv[2][0])) {
+	fprintf(stderr, "(E) Expect only lengths after a template: %s\n",
+		argv[2]);
 	return 3;
       }
-      unsigned i;
-      for (i = 0; i < pattern_len; i++) {
-	if (isalpha(pattern[i]))
-	  pattern[i] = toupper(pattern[i]);
-	else
-	  pattern[i] = '.';
+      /* A template on its own may be followed by a length range: */
+      if (full_alphabet && argc > 2 && isdigit(argv[2][0])) {
+	unsigned min = atoi(argv[2]);
+	unsigned max = argc > 3 ? (unsigned) atoi(argv[3]) : max_word_len;
+	if (min > min_word_len)
+	  min_word_len = min;
+	if (max < max_word_len)
+	  max_word_len = max;
       }
-      max_word_len = min_word_len = pattern_len;
     }
   }
 
@@ -333,7 +1121,10 @@ int main(int argc, char *argv[])
     unsigned i;
     for (i = 0; i < len; i++) {
       char ch = toupper(input[i]);
-      howmany[ch-'A']++;
+      if (ch == '?')
+	blanks++;
+      else
+	howmany[ch-'A']++;
     }
     /* Sort letters: */
     for (i = 0; i < 26; i++)
@@ -346,17 +1137,18 @@ int main(int argc, char *argv[])
       char ch = letters[i];
       fprintf(stderr, "%c(%u)", ch, howmany[ch-'A']);
     }
+    if (blanks)
+      fprintf(stderr, " and %u blank%s", blanks, blanks > 1 ? "s" : "");
     fputc('\n', stderr);
   }
   else
     fprintf(stderr, "Set of letters A-Z with unrestricted multiplicity\n");
 
-  if (pattern_len) {
-    /* check if pattern letters are in letters: */
-    for (i = 0; i < pattern_len; i++) {
-      if (pattern[i] != '.' && !strchr(letters, pattern[i])) {
-	fprintf(stderr, "(E) Pattern letter %c not in letter set\n",
-		pattern[i]);
+  if (pattern) {
+    /* check if required pattern letters are in letters: */
+    for (i = 0; i < 26; i++) {
+      if ((tpl.required >> i) & 1 && !blanks && !howmany[i]) {
+	fprintf(stderr, "(E) Pattern letter %c not in letter set\n", i+'A');
 	return 4;
       }
     }
@@ -368,6 +1160,33 @@ int main(int argc, char *argv[])
   else
     fprintf(stderr, "Generate words of lengths >= %u and <= %u\n",
 	    min_word_len, max_word_len);
-  words();
+
+  /* With blanks any letter may come next: */
+  candidates = blanks ? "ABCDEFGHIJKLMNOPQRSTUVWXYZ" : letters;
+
+  if (best_max) {
+    best = malloc(best_max * sizeof(*best));
+    if (!best) {
+      fprintf(stderr, "(E) Out of memory\n");
+      return 6;
+    }
+    /* Order letters on decreasing value for best_fill(): */
+    for (i = 0; i < 26; i++) {
+      unsigned j;
+      for (j = i; j > 0 && letter_value[value_order[j-1]] < letter_value[i];
+	   j--)
+	value_order[j] = value_order[j-1];
+      value_order[j] = i;
+    }
+    fprintf(stderr, "Keep the %u highest scoring words\n", best_max);
+  }
+  if (full_alphabet)
+    query();
+  else
+    words();
+  if (out_of_memory) {
+    fprintf(stderr, "(E) Out of memory\n");
+    return 6;
+  }
   return 0;
 }
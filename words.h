@@ -0,0 +1,68 @@
+/* Copyright (c) 2020 Geert Janssen, MIT License */
+
+/* Puzzle modes besides the generation of words from a set of letters.
+   Each is selected by a command line option and gets the operands that
+   follow the options; argv[1] is the first one.
+*/
+
+#ifndef WORDS_H
+#define WORDS_H
+
+/* Options shared by the modes: */
+extern unsigned num_threads;		/* number of threads to use */
+extern unsigned max_results;		/* 0: mode's default */
+extern int wordle_guess;		/* Wordle: best guesses, not words */
+extern const char *hangman_guessed;	/* Hangman: letters guessed */
+extern const char *bee_centre;		/* Spelling Bee: centre letter */
+extern int letter_value[26];		/* letter values for scoring (-v) */
+extern int validate_invalid;		/* Validation: tokens not words */
+
+/* Wordle: words that satisfy include/exclude/positional constraints. */
+extern int wordle_main(int argc, char *argv[]);
+
+/* Hangman: which letter to guess next. */
+extern int hangman_main(int argc, char *argv[]);
+
+/* Spelling Bee: words of reusable letters with a required centre letter. */
+extern int bee_main(int argc, char *argv[]);
+
+/* Multi-word anagrams of a phrase. */
+extern int anagram_main(int argc, char *argv[]);
+
+/* Scrabble: all moves of a rack on a board. */
+extern int scrabble_main(int argc, char *argv[]);
+
+/* Crossword: fill all slots of a grid. */
+extern int crossword_main(int argc, char *argv[]);
+
+/* Boggle: words traced through adjacent cells of a letter grid. */
+extern int boggle_main(int argc, char *argv[]);
+
+/* Isomorphs: words with a given pattern of repeated letters. */
+extern int isomorph_main(int argc, char *argv[]);
+
+/* Word ladders: shortest chain of one-letter changes between two words. */
+extern int ladder_main(int argc, char *argv[]);
+
+/* Fuzzy lookup: words within a small edit distance. */
+extern int fuzzy_main(int argc, char *argv[]);
+
+/* Validation: check a stream of tokens against the vocabulary. */
+extern int validate_main(int argc, char *argv[]);
+
+/* Hidden words: the words that occur as substrings of a text. */
+extern int hidden_main(int argc, char *argv[]);
+
+/* Rack neighbours: anagrams of a rack with a letter added or removed. */
+extern int rack_main(int argc, char *argv[]);
+
+/* Rack sweep: word counts for every rack of a size. */
+extern int sweep_main(int argc, char *argv[]);
+
+/* Levels: racks whose answers meet constraints, for word games. */
+extern int level_main(int argc, char *argv[]);
+
+/* Hints: the words of a rack by length and letter. */
+extern int hint_main(int argc, char *argv[]);
+
+#endif /* WORDS_H */